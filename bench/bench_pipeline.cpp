@@ -0,0 +1,123 @@
+#include "harness.h"
+#include "objectrec.h"
+#include "synthetic.h"
+
+// Per-stage microbenchmarks on synthetic inputs - no data files needed.
+//   objectrec_bench --json results.json
+//   objectrec_bench --filter morphology --min-time 2
+
+// 16:9 scene with objects scaled to the frame, cached across cases
+static const cv::Mat& scene(int width, int objects) {
+    static std::map<std::pair<int,int>, cv::Mat> cache;
+    auto key = std::make_pair(width, objects);
+    auto it = cache.find(key);
+    if (it != cache.end()) return it->second;
+    SceneParams p;
+    p.width = width;
+    p.height = width * 9 / 16;
+    p.numObjects = objects;
+    p.minSize = std::max(30, width / 40);
+    p.maxSize = std::max(60, width / 12);
+    p.seed = 1000 + width + objects;
+    std::vector<SceneObject> gt;
+    return cache[key] = renderScene(p, gt);
+}
+
+static cv::Mat cleanedScene(int width, int objects) {
+    return applyMorphology(applyThreshold(scene(width, objects)));
+}
+
+static const std::vector<int> WIDTHS = {640, 1920, 3840};
+
+static void registerAll() {
+    bench::add("threshold/isodata", {{"width", WIDTHS}}, [](bench::State& st) {
+        const cv::Mat& img = scene(st.arg("width"), 20);
+        while (st.keepRunning()) bench::doNotOptimize(applyThreshold(img, ThresholdMode::Isodata));
+        st.setItemsPerIteration(img.total(), "pixels");
+    });
+
+    bench::add("threshold/adaptive", {{"width", WIDTHS}, {"window", {15, 151}}}, [](bench::State& st) {
+        cv::Mat gray;
+        cv::cvtColor(scene(st.arg("width"), 20), gray, cv::COLOR_BGR2GRAY);
+        int window = st.arg("window");
+        while (st.keepRunning()) bench::doNotOptimize(applyAdaptiveThreshold(gray, window));
+        st.setItemsPerIteration(gray.total(), "pixels");
+    });
+
+    // Reference point for the adaptive path
+    bench::add("threshold/cv_adaptiveThreshold", {{"width", WIDTHS}, {"window", {15, 151}}}, [](bench::State& st) {
+        cv::Mat gray, out;
+        cv::cvtColor(scene(st.arg("width"), 20), gray, cv::COLOR_BGR2GRAY);
+        int window = st.arg("window");
+        while (st.keepRunning()) {
+            cv::adaptiveThreshold(gray, out, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY_INV, window, 10);
+            bench::doNotOptimize(out);
+        }
+        st.setItemsPerIteration(gray.total(), "pixels");
+    });
+
+    bench::add("morphology", {{"width", WIDTHS}, {"kernel", {3, 5, 9}}}, [](bench::State& st) {
+        cv::Mat binary = applyThreshold(scene(st.arg("width"), 20));
+        int k = st.arg("kernel");
+        while (st.keepRunning()) bench::doNotOptimize(applyMorphology(binary, k, k));
+        st.setItemsPerIteration(binary.total(), "pixels");
+    });
+
+    bench::add("segmentation", {{"width", WIDTHS}, {"objects", {5, 50, 200}}}, [](bench::State& st) {
+        cv::Mat cleaned = cleanedScene(st.arg("width"), st.arg("objects"));
+        while (st.keepRunning()) bench::doNotOptimize(segmentRegions(cleaned));
+        st.setItemsPerIteration(cleaned.total(), "pixels");
+    });
+
+    bench::add("features", {{"width", {1920}}, {"objects", {5, 50, 200}}}, [](bench::State& st) {
+        cv::Mat cleaned = cleanedScene(st.arg("width"), st.arg("objects"));
+        std::vector<RegionInfo> regions = segmentRegions(cleaned);
+        while (st.keepRunning())
+            for (auto& r : regions) bench::doNotOptimize(computeFeatures(cleaned, r));
+        st.setItemsPerIteration(regions.size(), "regions");
+    });
+
+    bench::add("classify", {{"db", {20, 1000, 100000}}}, [](bench::State& st) {
+        std::vector<TrainingEntry> db = makeSyntheticDB(st.arg("db"), syntheticShapes(), 7);
+        FeatureVector query = db[db.size() / 2].features;
+        while (st.keepRunning()) bench::doNotOptimize(classify(query, db));
+        st.setItemsPerIteration(1, "queries");
+    });
+
+    bench::add("prepEmbeddingImage", {{"width", WIDTHS}}, [](bench::State& st) {
+        const cv::Mat& img = scene(st.arg("width"), 5);
+        cv::Mat cleaned = cleanedScene(st.arg("width"), 5);
+        std::vector<RegionInfo> regions = segmentRegions(cleaned);
+        if (regions.empty()) return;
+        RegionInfo r = regions[0];
+        computeFeatures(cleaned, r);
+        cv::Mat embimg;
+        while (st.keepRunning()) {
+            prepEmbeddingImage(img, embimg, (int)r.centroid.x, (int)r.centroid.y, r.theta,
+                               r.minE1, r.maxE1, r.minE2, r.maxE2);
+            bench::doNotOptimize(embimg);
+        }
+        st.setItemsPerIteration(1, "crops");
+    });
+
+    // Nearest-neighbour scan over a gallery of ResNet18-sized embeddings
+    bench::add("embeddingDistance", {{"dims", {512}}, {"db", {100, 10000}}}, [](bench::State& st) {
+        int dims = st.arg("dims"), n = st.arg("db");
+        cv::RNG rng(3);
+        std::vector<cv::Mat> gallery(n);
+        for (auto& g : gallery) { g.create(1, dims, CV_32F); rng.fill(g, cv::RNG::NORMAL, 0, 1); }
+        cv::Mat query(1, dims, CV_32F);
+        rng.fill(query, cv::RNG::NORMAL, 0, 1);
+        while (st.keepRunning()) {
+            double best = 1e18;
+            for (auto& g : gallery) best = std::min(best, embeddingDistance(query, g));
+            bench::doNotOptimize(best);
+        }
+        st.setItemsPerIteration(n, "comparisons");
+    });
+}
+
+int main(int argc, char* argv[]) {
+    registerAll();
+    return bench::runAll(argc, argv);
+}
@@ -0,0 +1,151 @@
+#include "harness.h"
+#include <ctime>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace bench {
+
+const volatile void* sink = nullptr;
+
+struct Case {
+    std::string name;
+    Grid grid;
+    std::function<void(State&)> fn;
+};
+
+static std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+// User + kernel time of all threads. UCRT's clock() is wall time since process
+// start, so Windows needs GetProcessTimes.
+static double processCpuSeconds() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user);
+    auto ticks = [](const FILETIME& f) { return ((unsigned long long)f.dwHighDateTime << 32) | f.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) * 1e-7;   // 100 ns units
+#else
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+State::State(const std::map<std::string, int>& a, double t) : args(a), minTime(t) {}
+
+bool State::keepRunning() {
+    auto now = std::chrono::steady_clock::now();
+    double cpuNow = processCpuSeconds();
+    if (!started) {
+        started = true;
+        start = now;
+        cpuStart = cpuNow;
+        return true;
+    }
+    iterations++;
+    seconds = std::chrono::duration<double>(now - start).count();
+    cpuSeconds = cpuNow - cpuStart;
+    return seconds < minTime;
+}
+
+void add(const std::string& name, const Grid& grid, std::function<void(State&)> fn) {
+    registry().push_back({name, grid, std::move(fn)});
+}
+
+// Cartesian product of the argument grid
+static void expand(const Grid& grid, size_t i, std::map<std::string, int>& cur,
+                   std::vector<std::map<std::string, int>>& out) {
+    if (i == grid.size()) { out.push_back(cur); return; }
+    for (int v : grid[i].second) {
+        cur[grid[i].first] = v;
+        expand(grid, i + 1, cur, out);
+    }
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string o;
+    for (char c : s) { if (c == '"' || c == '\\') o += '\\'; o += c; }
+    return o;
+}
+
+int runAll(int argc, char* argv[]) {
+    std::string filter, jsonPath;
+    double minTime = 0.5;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if      (a == "--filter"   && i + 1 < argc) filter = argv[++i];
+        else if (a == "--min-time" && i + 1 < argc) minTime = std::stod(argv[++i]);
+        else if (a == "--json"     && i + 1 < argc) jsonPath = argv[++i];
+        else {
+            std::cout << "Usage: objectrec_bench [--filter SUBSTR] [--min-time SECONDS] [--json PATH]" << std::endl;
+            return a == "--help" ? 0 : 1;
+        }
+    }
+
+    struct Result { std::string name; long iterations; double nsPerIter, cpuNsPerIter, itemsPerSec; std::string unit; };
+    std::vector<Result> results;
+    std::cout << std::left << std::setw(56) << "Benchmark" << std::right
+              << std::setw(12) << "Iterations" << std::setw(16) << "Time/iter"
+              << std::setw(24) << "Throughput" << std::endl;
+    for (auto& c : registry()) {
+        std::vector<std::map<std::string, int>> combos;
+        std::map<std::string, int> cur;
+        expand(c.grid, 0, cur, combos);
+        for (auto& args : combos) {
+            std::string name = c.name;
+            for (auto& [key, value] : c.grid) name += "/" + key + ":" + std::to_string(args[key]);
+            if (!filter.empty() && name.find(filter) == std::string::npos) continue;
+
+            State st(args, minTime);
+            c.fn(st);
+            if (st.iterations == 0) continue;
+            Result r{name, st.iterations, st.seconds * 1e9 / st.iterations,
+                     st.cpuSeconds * 1e9 / st.iterations, st.itemsPerIter * st.iterations / st.seconds, st.itemUnit};
+            results.push_back(r);
+
+            std::ostringstream tput;
+            tput << std::fixed << std::setprecision(2);
+            if (r.itemsPerSec >= 1e6) tput << r.itemsPerSec / 1e6 << " M";
+            else if (r.itemsPerSec >= 1e3) tput << r.itemsPerSec / 1e3 << " k";
+            else tput << r.itemsPerSec << " ";
+            tput << r.unit << "/s";
+            std::cout << std::left << std::setw(56) << r.name << std::right
+                      << std::setw(12) << r.iterations
+                      << std::setw(13) << std::fixed << std::setprecision(3) << r.nsPerIter / 1e6 << " ms"
+                      << std::setw(24) << tput.str() << std::endl;
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream f(jsonPath);
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        f << "{\n  \"context\": {\n    \"date\": \"" << date << "\",\n    \"library\": \"objectrec_bench\"\n  },\n"
+          << "  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            auto& r = results[i];
+            f << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"run_name\": \"" << jsonEscape(r.name)
+              << "\", \"run_type\": \"iteration\", \"repetitions\": 1, \"repetition_index\": 0, \"threads\": 1"
+              << ", \"iterations\": " << r.iterations
+              << ", \"real_time\": " << std::setprecision(1) << std::fixed << r.nsPerIter
+              << ", \"cpu_time\": " << r.cpuNsPerIter
+              << ", \"time_unit\": \"ns\", \"items_per_second\": " << std::setprecision(3) << r.itemsPerSec
+              << ", \"item_unit\": \"" << jsonEscape(r.unit) << "\"}"
+              << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        f << "  ]\n}\n";
+        std::cout << "Wrote " << results.size() << " results to " << jsonPath << std::endl;
+    }
+    return 0;
+}
+
+}
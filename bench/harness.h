@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Minimal bundled benchmark harness (no external dependency). Each case is
+// registered with a grid of named integer arguments and expanded into one run
+// per combination. Output is a table on stdout and optionally JSON in Google
+// Benchmark's format (readable by its compare.py), so runs from different builds
+// can be diffed. cpu_time is process CPU time, so it includes OpenCV worker threads.
+namespace bench {
+
+extern const volatile void* sink;
+
+// Keeps a result alive so the optimizer (including LTO) can't drop the work producing it
+template <class T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    sink = static_cast<const volatile void*>(&value);
+#endif
+}
+
+class State {
+public:
+    explicit State(const std::map<std::string, int>& args, double minTime);
+    int arg(const std::string& key) const { return args.at(key); }
+    // Loop condition for the timed region; setup done before the first call is not timed
+    bool keepRunning();
+    // Work done per iteration, reported as <unit>/s
+    void setItemsPerIteration(double items, const std::string& unit) { itemsPerIter = items; itemUnit = unit; }
+
+    long iterations = 0;
+    double seconds = 0, cpuSeconds = 0;
+    double itemsPerIter = 0;
+    std::string itemUnit;
+private:
+    std::map<std::string, int> args;
+    double minTime;
+    bool started = false;
+    std::chrono::steady_clock::time_point start;
+    double cpuStart = 0;
+};
+
+using Grid = std::vector<std::pair<std::string, std::vector<int>>>;
+void add(const std::string& name, const Grid& grid, std::function<void(State&)> fn);
+
+// Flags: --filter SUBSTR  --min-time SECONDS  --json PATH
+int runAll(int argc, char* argv[]);
+
+}
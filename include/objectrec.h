@@ -1,28 +1,57 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
-cv::Mat applyThreshold(const cv::Mat& src);
+// ISODATA picks one global threshold; Adaptive compares each pixel to its local mean
+enum class ThresholdMode { Isodata, Adaptive };
+cv::Mat applyThreshold(const cv::Mat& src, ThresholdMode mode=ThresholdMode::Isodata);
+// gray must be CV_8UC1; window<=0 picks a quarter of the larger image side
+cv::Mat applyAdaptiveThreshold(const cv::Mat& gray, int window=0, double k=0.15);
+// Grayscale + 5x5 Gaussian blur that both threshold modes start from
+cv::Mat blurredGray(const cv::Mat& src);
+// The two halves of the ISODATA path, on an already blurred CV_8UC1 image
+double computeIsodataThreshold(const cv::Mat& blurred);
+cv::Mat applyFixedThreshold(const cv::Mat& blurred, double thresh);
 cv::Mat applyMorphology(const cv::Mat& binary);
+// Same with explicit square kernel sizes; the default is opening 3, closing 5
+cv::Mat applyMorphology(const cv::Mat& binary, int openSize, int closeSize);
+// Recomputes only the dirty rects of a previous applyMorphology() result
+cv::Mat applyMorphology(const cv::Mat& binary, const std::vector<cv::Rect>& dirty, const cv::Mat& previous);
 
 struct RegionInfo {
     int label;
     cv::Point2f centroid;
     double area;
     cv::Rect boundingBox;
-    float theta;
-    float minE1, maxE1, minE2, maxE2;
+    float theta = 0;
+    float minE1 = 0, maxE1 = 0, minE2 = 0, maxE2 = 0;
+    cv::RotatedRect orientedBox;   // filled in by computeFeatures
 };
-std::vector<RegionInfo> segmentRegions(const cv::Mat& binary, cv::Mat& labelViz);
+// Pass labelMap only when the regions will be rendered
+std::vector<RegionInfo> segmentRegions(const cv::Mat& binary, cv::Mat* labelMap=nullptr, int minArea=500);
+// Relabels only `dirty`, keeping previous regions outside it (no visualization)
+std::vector<RegionInfo> segmentRegions(const cv::Mat& binary, const cv::Rect& dirty,
+                                       const std::vector<RegionInfo>& previous);
 
 struct FeatureVector {
     double percentFilled;
     double hwRatio;
     double hu1, hu2, hu3;
 };
-FeatureVector computeFeatures(const cv::Mat& binary, const RegionInfo& region, cv::Mat& display);
+// Also stores orientation, oriented box and axis extents into region
+FeatureVector computeFeatures(const cv::Mat& binary, RegionInfo& region);
 
 struct TrainingEntry {
     std::string label;
@@ -32,9 +61,199 @@ void saveTrainingData(const std::vector<TrainingEntry>& db, const std::string& p
 std::vector<TrainingEntry> loadTrainingData(const std::string& path);
 std::string classify(const FeatureVector& fv, const std::vector<TrainingEntry>& db, double threshold=3.0);
 
+// Threshold -> morphology -> segmentation -> features of the largest region
+struct PipelineResult {
+    cv::Mat binary, cleaned, labelMap;   // only kept when keepImages is set
+    std::vector<RegionInfo> regions;
+    FeatureVector features{};            // of regions[0], zero when nothing was found
+};
+PipelineResult runPipeline(const cv::Mat& src, ThresholdMode mode, bool keepImages=false);
+// Coarse-to-fine: decodes at 1/factor resolution in grayscale for threshold, morphology
+// and segmentation, then recomputes every region on a full-resolution crop of its bbox
+// (regions lost at full resolution are dropped). factor must be >= 1. fullImage
+// receives the full-resolution decode.
+PipelineResult runCoarseToFine(const std::string& path, int factor, ThresholdMode mode, cv::Mat& fullImage);
+
+// Persistent cache of each image's region and features, keyed by a hash of the
+// file bytes plus the pipeline parameters, so re-evaluation skips the image pipeline
+struct StoredFeatures {
+    bool found = false;
+    RegionInfo region{};
+    FeatureVector features{};
+};
+class FeatureStore {
+public:
+    explicit FeatureStore(const std::string& path);
+    // Safe to call from parallel loops; runs the pipeline only on a miss
+    StoredFeatures get(const std::string& imagePath, ThresholdMode mode);
+    void save();
+    int hits() const { return hitCount; }
+    int misses() const { return missCount; }
+private:
+    std::string path;
+    std::map<std::string, StoredFeatures> entries;
+    std::mutex mtx;
+    int hitCount = 0, missCount = 0;
+};
+
+// One fully processed GUI image, including its rendered debug views
+struct GuiFrame {
+    cv::Mat src;
+    PipelineResult result;
+    cv::Mat regionsView, featuresView;
+};
+
+// LRU cache of processed images by index. Misses and prefetches run on background
+// threads; entries still being computed are never evicted.
+class ResultCache {
+public:
+    using Loader = std::function<std::shared_ptr<GuiFrame>(int)>;
+    ResultCache(Loader loader, size_t capacity);
+    // Blocks only until this index has been processed
+    std::shared_ptr<GuiFrame> get(int idx);
+    void prefetch(int idx);
+private:
+    std::shared_future<std::shared_ptr<GuiFrame>> lookup(int idx);
+    Loader loader;
+    size_t capacity;
+    std::list<int> order;   // most recently used first
+    std::map<int, std::pair<std::shared_future<std::shared_ptr<GuiFrame>>, std::list<int>::iterator>> entries;
+};
+
+// Cross-validation and unknown-threshold sweeps over cached features.
+// Distances are scaled by the stdevs of the known set, computed once.
+struct CrossValResult {
+    std::vector<std::string> predicted;   // nearest out-of-fold label per known sample
+    std::vector<double> knownDist;        // and its scaled distance
+    std::vector<double> unknownDist;      // nearest distance of each novel object to any known sample
+};
+// folds<=1 means leave-one-out
+CrossValResult crossValidate(const std::vector<TrainingEntry>& known,
+                             const std::vector<FeatureVector>& unknown, int folds);
+struct SweepRow { double threshold, accuracy, tpr, fpr; };
+std::vector<SweepRow> sweepThresholds(const std::vector<TrainingEntry>& known, const CrossValResult& result,
+                                      const std::vector<double>& thresholds);
+
+// Visualization - only called when an image is displayed or saved
+cv::Mat renderRegions(const cv::Mat& labelMap, const std::vector<RegionInfo>& regions);
+cv::Mat renderFeatures(const cv::Mat& binary, const RegionInfo& region, const FeatureVector& fv);
+// Draws the bbox and predicted label on the source image in place
+void renderPrediction(cv::Mat& img, const RegionInfo& region, const std::string& text,
+                      bool correct, cv::Point textAt);
+
+// Runs rendering and image encoding off the processing thread, in submission order
+class RenderWorker {
+public:
+    // submit() blocks once `capacity` tasks are waiting, so queued frames can't pile up
+    explicit RenderWorker(size_t maxQueued = 4);
+    ~RenderWorker();   // finishes every queued task
+    void submit(std::function<void()> task);
+    void wait();
+private:
+    void run();
+    size_t capacity;
+    std::mutex mtx;
+    std::condition_variable wake, notFull, idle;
+    std::deque<std::function<void()>> tasks;
+    bool busy = false, stopping = false;
+    std::thread worker;   // last, so it starts after the members it uses
+};
+
+// Bounded-queue pool that encodes and writes images off the processing thread
+struct WriterOptions {
+    int threads = 2;
+    size_t queueCapacity = 16;   // write() blocks once this many images are waiting
+    int jpegQuality = 95;
+    int pngCompression = 3;
+};
+class ImageWriter {
+public:
+    explicit ImageWriter(const WriterOptions& opts = WriterOptions());
+    ~ImageWriter();   // flushes, so every queued file is on disk before it returns
+    // Takes over img without copying pixels - the caller must not draw on it afterwards
+    void write(std::string path, cv::Mat img);
+    void flush();
+    void printStats() const;
+private:
+    void run();
+    WriterOptions opts;
+    mutable std::mutex mtx;
+    std::condition_variable notEmpty, notFull, idle;
+    std::deque<std::pair<std::string, cv::Mat>> queue;
+    int active = 0;
+    bool stopping = false;
+    long files = 0, failures = 0;
+    double bytes = 0, encodeSec = 0;
+    int64 firstWrite = 0, lastDone = 0;   // ticks from the first write() to the last finished file
+    std::vector<std::thread> workers;   // last, so they start after the members they use
+};
+
 // Task 9: CNN Embeddings
 void prepEmbeddingImage(const cv::Mat& frame, cv::Mat& embimage,
                          int cx, int cy, float theta,
                          float minE1, float maxE1, float minE2, float maxE2);
 cv::Mat getEmbedding(const cv::Mat& roi, cv::dnn::Net& net);
 double embeddingDistance(const cv::Mat& a, const cv::Mat& b);
+// Runs the pipeline on src and returns the rotation-normalized crop of the largest region
+bool prepEmbeddingCrop(const cv::Mat& src, ThresholdMode mode, cv::Mat& crop);
+
+// DNN runtime selection. backend: default|opencv|openvino|cuda, target: cpu|opencl|opencl_fp16|cuda|cuda_fp16,
+// threads<=0 keeps OpenCV's default. Works with full or truncated (prepare_model.py) models.
+struct DnnOptions {
+    std::string backend = "default";
+    std::string target = "cpu";
+    int threads = 0;
+    bool warmup = true;   // one forward pass at load so the first real call is not an outlier
+};
+cv::dnn::Net loadEmbeddingNet(const std::string& path, const DnnOptions& opts = DnnOptions());
+
+// Motion gating for static-camera video: compares a downscaled frame against the
+// frame the cached results came from and reports where it differs
+class MotionGate {
+public:
+    explicit MotionGate(int downscale=8, int diffThresh=20, int minChangedPixels=4);
+    // Returns false when nothing changed; otherwise dirty holds full-resolution rects
+    // and only those cells of the reference take the new frame
+    bool update(const cv::Mat& frame, std::vector<cv::Rect>& dirty);
+    // Whole last frame becomes the reference; call after reprocessing the full frame
+    void resetReference() { if (!last.empty()) reference = last.clone(); }
+    int framesSeen() const { return seen; }
+    int framesSkipped() const { return skipped; }
+private:
+    int downscale, diffThresh, minChangedPixels;
+    int seen = 0, skipped = 0;
+    cv::Mat reference, last;
+};
+
+// Embedding export: float32 .npy files written and read one row at a time
+class NpyWriter {
+public:
+    NpyWriter(const std::string& path, int cols);
+    ~NpyWriter();   // closes if still open
+    void append(const float* row);
+    void close();   // patches the final row count into the header
+private:
+    std::ofstream f;
+    int cols, rows = 0;
+};
+class NpyReader {
+public:
+    explicit NpyReader(const std::string& path);
+    bool next(std::vector<float>& row);
+    int rows = 0, cols = 0;
+private:
+    std::ifstream f;
+};
+
+// PCA from running sums, so memory is O(dims^2) regardless of how many vectors are added
+class StreamingPCA {
+public:
+    void add(const float* v, int dims);
+    void compute(int components);
+    std::vector<float> project(const float* v) const;
+    int count() const { return n; }
+private:
+    int n = 0;
+    cv::Mat sum, sumSq;      // 1 x D and D x D, CV_64F
+    cv::Mat mean, basis;     // set by compute()
+};
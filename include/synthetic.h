@@ -0,0 +1,40 @@
+#pragma once
+#include "objectrec.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Deterministic synthetic scenes for benchmarks and accuracy regressions.
+// Everything is driven by cv::RNG so the same seed gives the same pixels on every platform.
+
+struct SceneParams {
+    int width = 1280, height = 720;
+    int numObjects = 5;
+    int minSize = 60, maxSize = 200;   // object extent in pixels before rotation
+    bool rotate = true;
+    double noiseSigma = 4.0;           // gaussian pixel noise
+    double gradient = 0.4;             // 0 = flat lighting, 1 = background goes to black on one side
+    std::vector<std::string> shapes;   // empty = all of syntheticShapes()
+    uint64_t seed = 1;
+};
+
+struct SceneObject {
+    std::string shape;
+    cv::Rect boundingBox;
+    cv::Point2f center;
+    float angle;                       // degrees
+};
+
+const std::vector<std::string>& syntheticShapes();
+
+// Renders a BGR scene with dark objects on a lit background; ground truth goes to `objects`.
+// Objects never overlap or touch the border, so fewer than numObjects may fit.
+cv::Mat renderScene(const SceneParams& params, std::vector<SceneObject>& objects);
+
+// Binary mask (255 = object) of a single shape, used for feature prototypes
+cv::Mat renderShapeMask(const std::string& shape, int size, float angle, double aspect);
+
+// Training DB of `entries` rows spread over the given shapes. Per-shape feature
+// distributions come from real computeFeatures() runs on rendered masks.
+std::vector<TrainingEntry> makeSyntheticDB(int entries, const std::vector<std::string>& shapes,
+                                           uint64_t seed);
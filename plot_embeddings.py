@@ -1,55 +1,19 @@
-import cv2
 import numpy as np
 import matplotlib.pyplot as plt
-import os
 
-MODEL_PATH = "data/resnet18-v2-7.onnx"
-IMG_DIR = "data/test_images/"
-NET_SIZE = 224
+# Embeddings, PCA and labels are produced by: objectrec --export-embeddings
+PCA_PATH = "results/embeddings_pca.npy"
+LABELS_PATH = "results/embedding_labels.txt"
 
-OBJECTS = {
-    "object1": ["obj1_1.jpeg", "obj1_2.jpeg", "obj1_3.jpeg"],
-    "object2": ["obj2_1.jpeg", "obj2_2.jpeg", "obj2_3.jpeg"],
-    "object3": ["obj3_1.jpeg", "obj3_2.jpeg", "obj3_3.jpeg"],
-    "object4": ["obj4_1.jpeg", "obj4_2.jpeg", "obj4_3.jpeg"],
-    "object5": ["obj5_1.jpeg", "obj5_2.jpeg", "obj5_3.jpeg"],
-}
-
-net = cv2.dnn.readNetFromONNX(MODEL_PATH)
-print("ResNet18 loaded")
-
-embeddings = []
-labels = []
-
-for label, fnames in OBJECTS.items():
-    for fname in fnames:
-        img = cv2.imread(IMG_DIR + fname)
-        if img is None:
-            print(f"Could not load {fname}")
-            continue
-        resized = cv2.resize(img, (NET_SIZE, NET_SIZE))
-        blob = cv2.dnn.blobFromImage(resized, (1.0/255.0)*(1/0.226),
-                                      (NET_SIZE, NET_SIZE),
-                                      (124, 116, 104), True, False, cv2.CV_32F)
-        net.setInput(blob)
-        try:
-            emb = net.forward("onnx_node!resnetv22_flatten0_reshape0")
-        except:
-            emb = net.forward()
-        embeddings.append(emb.flatten())
-        labels.append(label)
-        print(f"Embedded: {label} - {fname}")
-
-embeddings = np.array(embeddings)
-
-# PCA to 2D
-mean = np.mean(embeddings, axis=0)
-centered = embeddings - mean
-U, s, Vt = np.linalg.svd(centered, full_matrices=False)
-proj = centered @ Vt[:2].T
+proj = np.load(PCA_PATH)
+with open(LABELS_PATH) as f:
+    labels = [line.split(",")[0] for line in f if line.strip()]
+print(f"Loaded {len(labels)} projected embeddings")
 
 # Plot
-colors = {"object1":"red","object2":"blue","object3":"green","object4":"orange","object5":"purple"}
+names = sorted(set(labels), key=lambda l: int(l.replace("object", "")) if l.startswith("object") else l)
+cmap = plt.get_cmap("tab10")
+colors = {l: cmap(i % 10) for i, l in enumerate(names)}
 plt.figure(figsize=(8,6))
 for i, (x, y) in enumerate(proj):
     lbl = labels[i]
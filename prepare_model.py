@@ -0,0 +1,183 @@
+import argparse
+import glob
+import os
+import time
+
+import cv2
+import numpy as np
+import onnx
+import onnx.utils
+
+# Prepares the embedding model for: objectrec --cnn / --export-embeddings / --model-report --model PATH
+#
+#   python prepare_model.py data/resnet18-v2-7.onnx --fp16 --int8 --calib-dir results/crops
+#   python prepare_model.py --make-test-model data/test_embed.onnx   (small local model for CPU checks)
+#
+# Writes <stem>_trunc.onnx ending at the embedding layer, plus _fp16 / _int8 variants of it.
+# Calibration crops (TRAIN_SET only) come from: objectrec --export-embeddings --save-crops
+
+EMBED_OUTPUT = "resnetv22_flatten0_reshape0"
+
+
+def preprocess(img):
+    # Same resize, scale, mean and channel order as getEmbedding() in src/embedding.cpp
+    img = cv2.resize(img, (224, 224))
+    if img.ndim == 2:
+        img = cv2.cvtColor(img, cv2.COLOR_GRAY2BGR)
+    return cv2.dnn.blobFromImage(img, (1.0 / 255.0) * (1.0 / 0.226), (224, 224),
+                                 (124, 116, 104), swapRB=True, crop=False)
+
+
+def make_test_model(path, seed=0):
+    # Two convs, global pooling and a classifier head, with the same embedding
+    # output name as ResNet18 so the truncation and C++ lookup paths are exercised
+    from onnx import TensorProto, helper, numpy_helper
+    rng = np.random.default_rng(seed)
+    w1 = rng.normal(0, 0.1, (16, 3, 3, 3)).astype(np.float32)
+    w2 = rng.normal(0, 0.1, (32, 16, 3, 3)).astype(np.float32)
+    fc = rng.normal(0, 0.1, (10, 32)).astype(np.float32)
+    inits = [numpy_helper.from_array(w1, "conv1_w"), numpy_helper.from_array(w2, "conv2_w"),
+             numpy_helper.from_array(fc, "fc_w"), numpy_helper.from_array(np.zeros(10, np.float32), "fc_b")]
+    nodes = [
+        helper.make_node("Conv", ["data", "conv1_w"], ["c1"], name="conv1", strides=[2, 2], pads=[1, 1, 1, 1]),
+        helper.make_node("Relu", ["c1"], ["r1"], name="relu1"),
+        helper.make_node("Conv", ["r1", "conv2_w"], ["c2"], name="conv2", strides=[2, 2], pads=[1, 1, 1, 1]),
+        helper.make_node("Relu", ["c2"], ["r2"], name="relu2"),
+        helper.make_node("GlobalAveragePool", ["r2"], ["pool"], name="pool"),
+        helper.make_node("Flatten", ["pool"], [EMBED_OUTPUT], name=EMBED_OUTPUT, axis=1),
+        helper.make_node("Gemm", [EMBED_OUTPUT, "fc_w", "fc_b"], ["resnetv22_dense0_fwd"],
+                         name="resnetv22_dense0_fwd", transB=1),
+    ]
+    graph = helper.make_graph(
+        nodes, "test_embed",
+        [helper.make_tensor_value_info("data", TensorProto.FLOAT, [1, 3, 224, 224])],
+        [helper.make_tensor_value_info("resnetv22_dense0_fwd", TensorProto.FLOAT, [1, 10])],
+        inits)
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 13)])
+    model.ir_version = 8
+    onnx.checker.check_model(model)
+    onnx.save(model, path)
+    print(f"Wrote test model {path}")
+
+
+def truncate(src, dst):
+    model = onnx.load(src)
+    outputs = {o for n in model.graph.node for o in n.output}
+    if EMBED_OUTPUT not in outputs:
+        raise SystemExit(f"{src} has no '{EMBED_OUTPUT}' output")
+    inits = {i.name for i in model.graph.initializer}
+    inputs = [i.name for i in model.graph.input if i.name not in inits]
+    onnx.utils.extract_model(src, dst, inputs, [EMBED_OUTPUT])
+    print(f"Wrote truncated model {dst}")
+
+
+def to_fp16(src, dst):
+    # fp16 through the whole graph including I/O; boundary Cast nodes (keep_io_types)
+    # break OpenCV's importer, and OpenCV converts the float32 input itself
+    from onnxruntime.transformers.float16 import convert_float_to_float16
+    onnx.save(convert_float_to_float16(onnx.load(src), keep_io_types=False), dst)
+    print(f"Wrote fp16 model {dst}")
+
+
+def calibration_blobs(calib_dir, count):
+    paths = sorted(glob.glob(os.path.join(calib_dir, "*"))) if calib_dir else []
+    blobs = [preprocess(img) for img in (cv2.imread(p) for p in paths) if img is not None]
+    if not blobs:
+        print("Warning: no calibration crops found, calibrating on random inputs")
+        rng = np.random.default_rng(0)
+        blobs = [rng.normal(0, 1, (1, 3, 224, 224)).astype(np.float32) for _ in range(count)]
+    print(f"Calibrating on {len(blobs)} inputs")
+    return blobs
+
+
+def to_int8(src, dst, blobs):
+    from onnxruntime.quantization import (CalibrationDataReader, QuantFormat, QuantType,
+                                          quantize_static)
+    from onnxruntime.quantization.shape_inference import quant_pre_process
+    input_name = onnx.load(src).graph.input[0].name
+
+    class Reader(CalibrationDataReader):
+        def __init__(self):
+            self.it = iter(blobs)
+
+        def get_next(self):
+            blob = next(self.it, None)
+            return None if blob is None else {input_name: blob}
+
+    # QOperator emits QLinearConv etc., which OpenCV DNN imports; QDQ needs a newer OpenCV
+    prepped = dst + ".pre.onnx"
+    quant_pre_process(src, prepped, skip_symbolic_shape=True)
+    quantize_static(prepped, dst, Reader(), quant_format=QuantFormat.QOperator,
+                    activation_type=QuantType.QUInt8, weight_type=QuantType.QInt8)
+    os.remove(prepped)
+    print(f"Wrote int8 model {dst}")
+
+
+def compare(reference, variants, blobs, runs):
+    # Embedding agreement and latency against the truncated float32 model
+    import onnxruntime as ort
+
+    def session(path):
+        s = ort.InferenceSession(path, providers=["CPUExecutionProvider"])
+        inp = s.get_inputs()[0]
+        return s, (inp.name, np.float16 if inp.type == "tensor(float16)" else np.float32)
+
+    def embed(sess, name, blob):
+        return sess.run(None, {name[0]: blob.astype(name[1])})[0].reshape(-1).astype(np.float32)
+
+    ref, ref_in = session(reference)
+    ref_emb = [embed(ref, ref_in, b) for b in blobs]
+    print(f"\n{'model':<40}{'ms/emb':>10}{'cos':>10}{'min cos':>10}")
+    for path in [reference] + variants:
+        sess, name = session(path)
+        embed(sess, name, blobs[0])
+        start = time.perf_counter()
+        for _ in range(runs):
+            for b in blobs:
+                embed(sess, name, b)
+        ms = (time.perf_counter() - start) * 1000 / (runs * len(blobs))
+        cos = [float(np.dot(e, r) / max(np.linalg.norm(e) * np.linalg.norm(r), 1e-12))
+               for e, r in zip((embed(sess, name, b) for b in blobs), ref_emb)]
+        print(f"{os.path.basename(path):<40}{ms:>10.2f}{np.mean(cos):>10.4f}{np.min(cos):>10.4f}")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Truncate and quantize the embedding model")
+    ap.add_argument("model", nargs="?", help="full ONNX model, e.g. data/resnet18-v2-7.onnx")
+    ap.add_argument("--make-test-model", metavar="PATH", help="write a small seeded model (prepared in place of MODEL if none is given)")
+    ap.add_argument("--out-dir", help="output directory (default: next to the model)")
+    ap.add_argument("--fp16", action="store_true", help="also write an fp16 variant")
+    ap.add_argument("--int8", action="store_true", help="also write a statically quantized int8 variant")
+    ap.add_argument("--calib-dir", help="training crops written by objectrec --export-embeddings --save-crops")
+    ap.add_argument("--calib-count", type=int, default=16, help="random inputs when no crops are found")
+    ap.add_argument("--runs", type=int, default=5, help="timing passes per input in the report")
+    args = ap.parse_args()
+
+    if args.make_test_model:
+        make_test_model(args.make_test_model)
+        if not args.model:
+            args.model = args.make_test_model
+    if not args.model:
+        ap.error("a model path or --make-test-model is required")
+
+    out_dir = args.out_dir or os.path.dirname(os.path.abspath(args.model))
+    os.makedirs(out_dir, exist_ok=True)
+    stem = os.path.join(out_dir, os.path.splitext(os.path.basename(args.model))[0])
+
+    trunc = stem + "_trunc.onnx"
+    truncate(args.model, trunc)
+    blobs = calibration_blobs(args.calib_dir, args.calib_count)
+    variants = []
+    if args.fp16:
+        to_fp16(trunc, stem + "_fp16.onnx")
+        variants.append(stem + "_fp16.onnx")
+    if args.int8:
+        to_int8(trunc, stem + "_int8.onnx", blobs)
+        variants.append(stem + "_int8.onnx")
+    compare(trunc, variants, blobs, args.runs)
+    print("\nFor OpenCV timings and accuracy on the evaluation set run:")
+    print("  objectrec --model-report " + " ".join([args.model, trunc] + variants))
+
+
+if __name__ == "__main__":
+    main()
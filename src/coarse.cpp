@@ -0,0 +1,101 @@
+#include "objectrec.h"
+#include <set>
+
+static cv::Mat decodeReduced(const std::string& path, int factor) {
+    // libjpeg/libpng scale down while decoding, which is much cheaper than a full decode
+    int flag = factor == 2 ? cv::IMREAD_REDUCED_GRAYSCALE_2
+             : factor == 4 ? cv::IMREAD_REDUCED_GRAYSCALE_4
+             : factor == 8 ? cv::IMREAD_REDUCED_GRAYSCALE_8 : -1;
+    if (flag != -1) return cv::imread(path, flag);
+    cv::Mat gray = cv::imread(path, cv::IMREAD_GRAYSCALE), small;
+    if (gray.empty() || factor <= 1) return gray;
+    cv::resize(gray, small, cv::Size(), 1.0 / factor, 1.0 / factor, cv::INTER_AREA);
+    return small;
+}
+
+PipelineResult runCoarseToFine(const std::string& path, int factor, ThresholdMode mode, cv::Mat& fullImage) {
+    PipelineResult res;
+    fullImage.release();
+    if (factor < 1) return res;
+    cv::Mat small = decodeReduced(path, factor);
+    if (small.empty()) return res;
+
+    cv::Mat blurred;
+    cv::GaussianBlur(small, blurred, cv::Size(5, 5), 0);
+    double thresh = 0;
+    int window = std::max(small.rows, small.cols) / 4;
+    cv::Mat binary;
+    if (mode == ThresholdMode::Adaptive) {
+        binary = applyAdaptiveThreshold(blurred, window);
+    } else {
+        thresh = computeIsodataThreshold(blurred);
+        binary = applyFixedThreshold(blurred, thresh);
+    }
+    cv::Mat cleaned = applyMorphology(binary);
+    cv::Mat coarseLabels;
+    std::vector<RegionInfo> coarse = segmentRegions(cleaned, &coarseLabels, 500 / (factor * factor));
+    if (coarse.empty()) return res;
+
+    fullImage = cv::imread(path);
+    if (fullImage.empty()) return res;
+    double sx = (double)fullImage.cols / small.cols, sy = (double)fullImage.rows / small.rows;
+    cv::Rect full(0, 0, fullImage.cols, fullImage.rows);
+
+    // Refine each region on a full-resolution crop. The padding covers the coarse
+    // bbox error plus the morphology reach, so the object does not touch the crop edge.
+    // Regions that vanish at full resolution are dropped, so every returned region
+    // has real orientation and axis extents.
+    int pad = 2 * factor + 8;
+    for (auto& c : coarse) {
+        cv::Point2f center(c.centroid.x * sx, c.centroid.y * sy);
+        cv::Rect bb = cv::Rect((int)(c.boundingBox.x * sx), (int)(c.boundingBox.y * sy),
+                               (int)std::ceil(c.boundingBox.width * sx), (int)std::ceil(c.boundingBox.height * sy)) & full;
+        cv::Rect crop = cv::Rect(bb.x - pad, bb.y - pad, bb.width + 2*pad, bb.height + 2*pad) & full;
+        cv::Mat grayCrop, blurCrop, binCrop;
+        cv::cvtColor(fullImage(crop), grayCrop, cv::COLOR_BGR2GRAY);
+        cv::GaussianBlur(grayCrop, blurCrop, cv::Size(5, 5), 0);
+        if (mode == ThresholdMode::Adaptive)
+            binCrop = applyAdaptiveThreshold(blurCrop, (int)(window * sx));
+        else
+            binCrop = applyFixedThreshold(blurCrop, thresh);
+        cv::Mat cleanCrop = applyMorphology(binCrop);
+        cv::Mat fineLabels;
+        std::vector<RegionInfo> fine = segmentRegions(cleanCrop, &fineLabels);
+        if (fine.empty()) continue;
+
+        // A crop can catch neighbours, so match by label: the blob under the coarse
+        // centroid, or when that is a hole (rings) the blob covering most of the
+        // coarse region's own pixels. No match means the region is dropped.
+        cv::Point local = cv::Point((int)center.x - crop.x, (int)center.y - crop.y);
+        local.x = std::min(std::max(local.x, 0), crop.width - 1);
+        local.y = std::min(std::max(local.y, 0), crop.height - 1);
+        std::set<int> kept;   // labels that passed the area filter
+        for (auto& f : fine) kept.insert(f.label);
+        int match = fineLabels.at<int>(local);
+        if (!kept.count(match)) {
+            match = 0;
+            std::map<int, int> votes;
+            for (int y = 0; y < crop.height; y += factor)
+                for (int x = 0; x < crop.width; x += factor) {
+                    int cx = std::min((int)((x + crop.x) / sx), coarseLabels.cols - 1);
+                    int cy = std::min((int)((y + crop.y) / sy), coarseLabels.rows - 1);
+                    int l = fineLabels.at<int>(y, x);
+                    if (kept.count(l) && coarseLabels.at<int>(cy, cx) == c.label) votes[l]++;
+                }
+            int best = 0;
+            for (auto& [l, n] : votes)
+                if (n > best) { best = n; match = l; }
+        }
+        if (match == 0) continue;
+        RegionInfo r = *std::find_if(fine.begin(), fine.end(), [match](const RegionInfo& f) { return f.label == match; });
+        FeatureVector fv = computeFeatures(cleanCrop, r);
+        if (res.regions.empty()) res.features = fv;
+        // Orientation and axis extents are translation invariant; only positions move
+        cv::Point2f offset((float)crop.x, (float)crop.y);
+        r.centroid += offset;
+        r.boundingBox += crop.tl();
+        r.orientedBox.center += offset;
+        res.regions.push_back(r);
+    }
+    return res;
+}
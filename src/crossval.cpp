@@ -0,0 +1,95 @@
+#include "objectrec.h"
+#include <cmath>
+#include <map>
+
+static std::vector<double> toVec(const FeatureVector& f) {
+    return { f.percentFilled, f.hwRatio, f.hu1, f.hu2, f.hu3 };
+}
+
+CrossValResult crossValidate(const std::vector<TrainingEntry>& known,
+                             const std::vector<FeatureVector>& unknown, int folds) {
+    int n = known.size(), u = unknown.size();
+    CrossValResult res;
+    res.predicted.assign(n, "unknown");
+    res.knownDist.assign(n, 1e18);
+    res.unknownDist.assign(u, 1e18);
+    if (n == 0) return res;
+
+    // Same per-feature scaling as classify(), but over the whole known set
+    std::vector<double> stdevs(5);
+    for (int f = 0; f < 5; f++) {
+        double mean = 0, var = 0;
+        for (auto& e : known) mean += toVec(e.features)[f];
+        mean /= n;
+        for (auto& e : known) { double d = toVec(e.features)[f] - mean; var += d*d; }
+        double s = sqrt(var / n);
+        stdevs[f] = s > 1e-6 ? s : 1.0;
+    }
+    cv::Mat scaled(n + u, 5, CV_64FC1);
+    for (int i = 0; i < n + u; i++) {
+        std::vector<double> v = toVec(i < n ? known[i].features : unknown[i - n]);
+        for (int f = 0; f < 5; f++) scaled.at<double>(i, f) = v[f] / stdevs[f];
+    }
+
+    // Every row (known and unknown) against every known sample, once
+    cv::Mat dist(n + u, n, CV_64FC1);
+    cv::parallel_for_(cv::Range(0, n + u), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            const double* a = scaled.ptr<double>(i);
+            double* out = dist.ptr<double>(i);
+            for (int j = 0; j < n; j++) {
+                const double* b = scaled.ptr<double>(j);
+                double d = 0;
+                for (int f = 0; f < 5; f++) d += (a[f]-b[f]) * (a[f]-b[f]);
+                out[j] = sqrt(d);
+            }
+        }
+    });
+
+    // Stratified folds: the k-th sample of each label goes to fold k % folds
+    std::vector<int> fold(n);
+    std::map<std::string, int> seenPerLabel;
+    for (int i = 0; i < n; i++)
+        fold[i] = folds > 1 ? seenPerLabel[known[i].label]++ % folds : i;
+
+    cv::parallel_for_(cv::Range(0, n + u), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            const double* row = dist.ptr<double>(i);
+            double best = 1e18;
+            int bestJ = -1;
+            for (int j = 0; j < n; j++) {
+                if (i < n && fold[j] == fold[i]) continue;
+                if (row[j] < best) { best = row[j]; bestJ = j; }
+            }
+            if (i < n) {
+                res.knownDist[i] = best;
+                if (bestJ >= 0) res.predicted[i] = known[bestJ].label;
+            } else {
+                res.unknownDist[i - n] = best;
+            }
+        }
+    });
+    return res;
+}
+
+std::vector<SweepRow> sweepThresholds(const std::vector<TrainingEntry>& known, const CrossValResult& result,
+                                      const std::vector<double>& thresholds) {
+    std::vector<SweepRow> rows(thresholds.size());
+    int n = known.size(), u = result.unknownDist.size();
+    cv::parallel_for_(cv::Range(0, (int)thresholds.size()), [&](const cv::Range& range) {
+        for (int t = range.start; t < range.end; t++) {
+            double thresh = thresholds[t];
+            int correctKnown = 0, acceptedUnknown = 0;
+            for (int i = 0; i < n; i++)
+                if (result.knownDist[i] <= thresh && result.predicted[i] == known[i].label) correctKnown++;
+            for (int i = 0; i < u; i++)
+                if (result.unknownDist[i] <= thresh) acceptedUnknown++;
+            SweepRow& r = rows[t];
+            r.threshold = thresh;
+            r.tpr = n > 0 ? (double)correctKnown / n : 0;
+            r.fpr = u > 0 ? (double)acceptedUnknown / u : 0;
+            r.accuracy = (n + u) > 0 ? (double)(correctKnown + u - acceptedUnknown) / (n + u) : 0;
+        }
+    });
+    return rows;
+}
@@ -1,6 +1,7 @@
 #include "objectrec.h"
 #include <opencv2/dnn.hpp>
 #include <cmath>
+#include <iostream>
 
 // Attribution: prepEmbeddingImage logic adapted from Bruce Maxwell utilities.cpp
 void prepEmbeddingImage(const cv::Mat& frame, cv::Mat& embimage,
@@ -44,13 +45,14 @@ cv::Mat getEmbedding(const cv::Mat& roi, cv::dnn::Net& net) {
 
     net.setInput(blob);
 
-    // Try to get embedding from flatten layer
-    try {
-        embedding = net.forward("onnx_node!resnetv22_flatten0_reshape0");
-    } catch (...) {
-        // Fallback: get last layer output
-        embedding = net.forward();
+    // Get embedding from flatten layer; a truncated model ends there, so its
+    // last output is the embedding. Looked up by name (OpenCV 4 prefixes ONNX
+    // node names, 5 does not) to avoid a throw per call.
+    for (const char* layer : {"onnx_node!resnetv22_flatten0_reshape0", "resnetv22_flatten0_reshape0"}) {
+        if (net.getLayerId(layer) >= 0) { embedding = net.forward(layer); break; }
     }
+    if (embedding.empty())
+        embedding = net.forward();
 
     return embedding.clone();
 }
@@ -59,3 +61,43 @@ double embeddingDistance(const cv::Mat& a, const cv::Mat& b) {
     cv::Mat diff = a - b;
     return cv::norm(diff, cv::NORM_L2);
 }
+
+bool prepEmbeddingCrop(const cv::Mat& src, ThresholdMode mode, cv::Mat& crop) {
+    PipelineResult res = runPipeline(src, mode);
+    if (res.regions.empty()) return false;
+    const RegionInfo& r = res.regions[0];
+    prepEmbeddingImage(src, crop, (int)r.centroid.x, (int)r.centroid.y, r.theta,
+                       r.minE1, r.maxE1, r.minE2, r.maxE2);
+    return true;
+}
+
+cv::dnn::Net loadEmbeddingNet(const std::string& path, const DnnOptions& opts) {
+    cv::dnn::Net net = cv::dnn::readNetFromONNX(path);
+    if (net.empty()) return net;
+
+    const std::map<std::string, int> backends = {
+        {"default",  cv::dnn::DNN_BACKEND_DEFAULT},
+        {"opencv",   cv::dnn::DNN_BACKEND_OPENCV},
+        {"openvino", cv::dnn::DNN_BACKEND_INFERENCE_ENGINE},
+        {"cuda",     cv::dnn::DNN_BACKEND_CUDA}
+    };
+    const std::map<std::string, int> targets = {
+        {"cpu",         cv::dnn::DNN_TARGET_CPU},
+        {"opencl",      cv::dnn::DNN_TARGET_OPENCL},
+        {"opencl_fp16", cv::dnn::DNN_TARGET_OPENCL_FP16},
+        {"cuda",        cv::dnn::DNN_TARGET_CUDA},
+        {"cuda_fp16",   cv::dnn::DNN_TARGET_CUDA_FP16}
+    };
+    if (backends.count(opts.backend)) net.setPreferableBackend(backends.at(opts.backend));
+    else std::cout << "Unknown DNN backend " << opts.backend << ", using default" << std::endl;
+    if (targets.count(opts.target)) net.setPreferableTarget(targets.at(opts.target));
+    else std::cout << "Unknown DNN target " << opts.target << ", using cpu" << std::endl;
+    // OpenCV DNN runs on the global OpenCV thread pool
+    if (opts.threads > 0) cv::setNumThreads(opts.threads);
+
+    if (opts.warmup) {
+        cv::Mat dummy(224, 224, CV_8UC3, cv::Scalar(128, 128, 128));
+        getEmbedding(dummy, net);
+    }
+    return net;
+}
@@ -0,0 +1,94 @@
+#include "objectrec.h"
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+// NPY v1.0 with the header padded to a fixed 128 bytes, so the row count can be
+// rewritten in place once the stream ends
+static const int NPY_HEADER = 128;
+
+static std::string npyHeader(int rows, int cols) {
+    std::string dict = "{'descr': '<f4', 'fortran_order': False, 'shape': ("
+                     + std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+    int headerLen = NPY_HEADER - 10;
+    dict.resize(headerLen - 1, ' ');
+    dict += '\n';
+    std::string h = "\x93NUMPY";
+    h += (char)1; h += (char)0;
+    h += (char)(headerLen & 0xFF); h += (char)(headerLen >> 8);
+    return h + dict;
+}
+
+NpyWriter::NpyWriter(const std::string& path, int numCols)
+    : f(path, std::ios::binary), cols(numCols) {
+    f << npyHeader(0, cols);
+}
+
+NpyWriter::~NpyWriter() {
+    if (f.is_open()) close();
+}
+
+void NpyWriter::append(const float* row) {
+    f.write((const char*)row, sizeof(float) * cols);
+    rows++;
+}
+
+void NpyWriter::close() {
+    f.seekp(0);
+    f << npyHeader(rows, cols);
+    f.close();
+}
+
+NpyReader::NpyReader(const std::string& path) : f(path, std::ios::binary) {
+    char pre[10];
+    if (!f.read(pre, 10) || std::memcmp(pre, "\x93NUMPY", 6) != 0) return;
+    int headerLen = (unsigned char)pre[8] | ((unsigned char)pre[9] << 8);
+    std::string dict(headerLen, ' ');
+    f.read(&dict[0], headerLen);
+    // Only the layout NpyWriter produces is supported
+    if (dict.find("'<f4'") == std::string::npos || dict.find("False") == std::string::npos) return;
+    size_t open = dict.find("'shape': (");
+    if (open == std::string::npos) return;
+    std::stringstream ss(dict.substr(open + 10));
+    char comma;
+    ss >> rows >> comma >> cols;
+}
+
+bool NpyReader::next(std::vector<float>& row) {
+    if (cols <= 0) return false;
+    row.resize(cols);
+    return (bool)f.read((char*)row.data(), sizeof(float) * cols);
+}
+
+void StreamingPCA::add(const float* v, int dims) {
+    cv::Mat x(1, dims, CV_32F, const_cast<float*>(v));
+    cv::Mat xd;
+    x.convertTo(xd, CV_64F);
+    if (sum.empty()) {
+        sum   = cv::Mat::zeros(1, dims, CV_64F);
+        sumSq = cv::Mat::zeros(dims, dims, CV_64F);
+    }
+    sum   += xd;
+    sumSq += xd.t() * xd;
+    n++;
+}
+
+void StreamingPCA::compute(int components) {
+    if (n == 0) return;
+    mean = sum / n;
+    // Covariance = E[x^T x] - mean^T mean
+    cv::Mat cov = sumSq / n - mean.t() * mean;
+    cv::Mat eigenvalues, eigenvectors;
+    cv::eigen(cov, eigenvalues, eigenvectors);   // rows sorted by descending eigenvalue
+    basis = eigenvectors.rowRange(0, std::min(components, eigenvectors.rows)).clone();
+}
+
+std::vector<float> StreamingPCA::project(const float* v) const {
+    cv::Mat x(1, mean.cols, CV_32F, const_cast<float*>(v));
+    cv::Mat xd;
+    x.convertTo(xd, CV_64F);
+    cv::Mat p = (xd - mean) * basis.t();
+    std::vector<float> out(p.cols);
+    for (int i = 0; i < p.cols; i++) out[i] = (float)p.at<double>(0, i);
+    return out;
+}
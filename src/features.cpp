@@ -1,6 +1,6 @@
 #include "objectrec.h"
 
-FeatureVector computeFeatures(const cv::Mat& binary, const RegionInfo& region, cv::Mat& display) {
+FeatureVector computeFeatures(const cv::Mat& binary, RegionInfo& region) {
     FeatureVector fv;
 
     cv::Mat mask = cv::Mat::zeros(binary.size(), CV_8UC1);
@@ -26,11 +26,12 @@ FeatureVector computeFeatures(const cv::Mat& binary, const RegionInfo& region, c
     std::vector<std::vector<cv::Point>> contours;
     cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
 
-    cv::RotatedRect rrect;
+    region.theta = theta;
     if (!contours.empty()) {
         std::vector<cv::Point> allPts;
         for (auto& c : contours) allPts.insert(allPts.end(), c.begin(), c.end());
-        rrect = cv::minAreaRect(allPts);
+        cv::RotatedRect rrect = cv::minAreaRect(allPts);
+        region.orientedBox = rrect;
         float rw = rrect.size.width, rh = rrect.size.height;
         fv.hwRatio = (rw > 0 && rh > 0) ? (float)std::min(rw,rh) / std::max(rw,rh) : 1.0;
 
@@ -47,23 +48,27 @@ FeatureVector computeFeatures(const cv::Mat& binary, const RegionInfo& region, c
                 minE2 = std::min(minE2, e2); maxE2 = std::max(maxE2, e2);
             }
         }
-        // Store into region (const_cast since we need to update)
-        const_cast<RegionInfo&>(region).theta = theta;
-        const_cast<RegionInfo&>(region).minE1 = minE1;
-        const_cast<RegionInfo&>(region).maxE1 = maxE1;
-        const_cast<RegionInfo&>(region).minE2 = minE2;
-        const_cast<RegionInfo&>(region).maxE2 = maxE2;
+        region.minE1 = minE1;
+        region.maxE1 = maxE1;
+        region.minE2 = minE2;
+        region.maxE2 = maxE2;
     } else {
         fv.hwRatio = 1.0;
     }
 
-    // Draw
+    return fv;
+}
+
+// Oriented box, primary axis, centroid and fill ratio drawn over the binary image
+cv::Mat renderFeatures(const cv::Mat& binary, const RegionInfo& region, const FeatureVector& fv) {
+    cv::Mat display;
     cv::cvtColor(binary, display, cv::COLOR_GRAY2BGR);
-    if (!contours.empty()) {
-        cv::Point2f pts[4]; rrect.points(pts);
+    if (region.orientedBox.size.area() > 0) {
+        cv::Point2f pts[4]; region.orientedBox.points(pts);
         for (int i = 0; i < 4; i++)
             cv::line(display, pts[i], pts[(i+1)%4], cv::Scalar(0,255,0), 2);
     }
+    double theta = region.theta;
     double axisLen = std::max(region.boundingBox.width, region.boundingBox.height) / 2.0;
     cv::Point2f cx2 = region.centroid;
     cv::Point2f p1(cx2.x + axisLen*cos(theta), cx2.y + axisLen*sin(theta));
@@ -72,6 +77,5 @@ FeatureVector computeFeatures(const cv::Mat& binary, const RegionInfo& region, c
     cv::circle(display, cx2, 5, cv::Scalar(255,0,0), -1);
     std::string txt = "Fill:" + std::to_string(fv.percentFilled).substr(0,4);
     cv::putText(display, txt, cv::Point(10,30), cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(255,255,0), 2);
-
-    return fv;
+    return display;
 }
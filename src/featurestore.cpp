@@ -0,0 +1,108 @@
+#include "objectrec.h"
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+
+// Bump when a pipeline stage changes its output so old entries stop matching
+static const std::string PIPELINE_VERSION = "v1";
+
+// 64-bit FNV-1a of the file contents
+static std::string hashFile(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) return "";
+    uint64_t h = 1469598103934665603ULL;
+    std::vector<char> buf(1 << 16);
+    while (true) {
+        f.read(buf.data(), buf.size());
+        std::streamsize n = f.gcount();
+        if (n <= 0) break;
+        for (std::streamsize i = 0; i < n; i++) {
+            h ^= (unsigned char)buf[i];
+            h *= 1099511628211ULL;
+        }
+    }
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << h;
+    return ss.str();
+}
+
+FeatureStore::FeatureStore(const std::string& storePath) : path(storePath) {
+    std::ifstream f(path);
+    if (!f.is_open()) return;
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty()) continue;
+        std::stringstream ss(line);
+        std::string key, tok;
+        std::getline(ss, key, ',');
+        std::vector<double> v;
+        while (std::getline(ss, tok, ',')) v.push_back(std::stod(tok));
+        if (v.size() != 24) continue;
+        StoredFeatures e;
+        RegionInfo& r = e.region;
+        e.found       = v[0] != 0;
+        r.label       = (int)v[1];
+        r.centroid    = cv::Point2f((float)v[2], (float)v[3]);
+        r.area        = v[4];
+        r.boundingBox = cv::Rect((int)v[5], (int)v[6], (int)v[7], (int)v[8]);
+        r.theta = (float)v[9];
+        r.minE1 = (float)v[10]; r.maxE1 = (float)v[11];
+        r.minE2 = (float)v[12]; r.maxE2 = (float)v[13];
+        r.orientedBox = cv::RotatedRect(cv::Point2f((float)v[14], (float)v[15]),
+                                        cv::Size2f((float)v[16], (float)v[17]), (float)v[18]);
+        e.features = {v[19], v[20], v[21], v[22], v[23]};
+        entries[key] = e;
+    }
+    std::cout << "Loaded " << entries.size() << " cached feature entries from " << path << std::endl;
+}
+
+StoredFeatures FeatureStore::get(const std::string& imagePath, ThresholdMode mode) {
+    std::string key = hashFile(imagePath) + "|"
+                    + (mode == ThresholdMode::Adaptive ? "adaptive" : "isodata") + "|"
+                    + PIPELINE_VERSION;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = entries.find(key);
+        if (it != entries.end()) { hitCount++; return it->second; }
+    }
+
+    StoredFeatures e;
+    cv::Mat src = cv::imread(imagePath);
+    if (!src.empty()) {
+        PipelineResult res = runPipeline(src, mode);
+        if (!res.regions.empty()) {
+            e.found    = true;
+            e.region   = res.regions[0];
+            e.features = res.features;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    missCount++;
+    // Unreadable files are not cached so they are retried next time
+    if (!src.empty()) entries[key] = e;
+    return e;
+}
+
+void FeatureStore::save() {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::ofstream f(path);
+    f << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (auto& [key, e] : entries) {
+        const RegionInfo& r = e.region;
+        const FeatureVector& fv = e.features;
+        f << key << "," << (e.found ? 1 : 0) << "," << r.label << ","
+          << r.centroid.x << "," << r.centroid.y << "," << r.area << ","
+          << r.boundingBox.x << "," << r.boundingBox.y << ","
+          << r.boundingBox.width << "," << r.boundingBox.height << ","
+          << r.theta << "," << r.minE1 << "," << r.maxE1 << "," << r.minE2 << "," << r.maxE2 << ","
+          << r.orientedBox.center.x << "," << r.orientedBox.center.y << ","
+          << r.orientedBox.size.width << "," << r.orientedBox.size.height << ","
+          << r.orientedBox.angle << ","
+          << fv.percentFilled << "," << fv.hwRatio << ","
+          << fv.hu1 << "," << fv.hu2 << "," << fv.hu3 << "\n";
+    }
+    std::cout << "Saved " << entries.size() << " cached feature entries to " << path << std::endl;
+}
@@ -0,0 +1,84 @@
+#include "objectrec.h"
+#include <fstream>
+
+ImageWriter::ImageWriter(const WriterOptions& options) : opts(options) {
+    for (int i = 0; i < std::max(1, opts.threads); i++)
+        workers.emplace_back(&ImageWriter::run, this);
+}
+
+ImageWriter::~ImageWriter() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ImageWriter::write(std::string path, cv::Mat img) {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        notFull.wait(lock, [this]{ return queue.size() < opts.queueCapacity; });
+        if (firstWrite == 0) firstWrite = cv::getTickCount();
+        queue.emplace_back(std::move(path), std::move(img));
+    }
+    notEmpty.notify_one();
+}
+
+void ImageWriter::flush() {
+    std::unique_lock<std::mutex> lock(mtx);
+    idle.wait(lock, [this]{ return queue.empty() && active == 0; });
+}
+
+void ImageWriter::run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        notEmpty.wait(lock, [this]{ return stopping || !queue.empty(); });
+        if (queue.empty()) break;
+        std::pair<std::string, cv::Mat> job = std::move(queue.front());
+        queue.pop_front();
+        active++;
+        lock.unlock();
+        notFull.notify_one();
+
+        // Encode to memory first so encode time is measured apart from disk I/O
+        std::string ext = job.first.substr(job.first.find_last_of('.') + 1);
+        std::vector<int> params;
+        if (ext == "jpg" || ext == "jpeg")
+            params = { cv::IMWRITE_JPEG_QUALITY, opts.jpegQuality };
+        else if (ext == "png")
+            params = { cv::IMWRITE_PNG_COMPRESSION, opts.pngCompression };
+        std::vector<uchar> buf;
+        cv::TickMeter tm;
+        tm.start();
+        bool ok = cv::imencode("." + ext, job.second, buf, params);
+        tm.stop();
+        if (ok) {
+            std::ofstream f(job.first, std::ios::binary);
+            f.write((const char*)buf.data(), buf.size());
+            ok = f.good();
+        }
+        job.second.release();
+
+        lock.lock();
+        active--;
+        lastDone = cv::getTickCount();
+        if (ok) { files++; bytes += buf.size(); encodeSec += tm.getTimeSec(); }
+        else { failures++; std::cout << "Failed to write: " << job.first << std::endl; }
+        if (queue.empty() && active == 0) idle.notify_all();
+    }
+}
+
+void ImageWriter::printStats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    // Only the span the writer had work, so pipeline time before the first image isn't counted
+    double elapsed = std::max((lastDone - firstWrite) / cv::getTickFrequency(), 1e-9);
+    std::cout << "Image writer: " << files << " files, "
+              << bytes / 1e6 << " MB, " << failures << " failed, "
+              << workers.size() << " threads" << std::endl;
+    if (files > 0)
+        std::cout << "  encode " << encodeSec * 1000.0 / files << " ms/file, "
+                  << files / elapsed << " files/s, "
+                  << bytes / 1e6 / elapsed << " MB/s wall" << std::endl;
+}
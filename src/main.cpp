@@ -1,13 +1,18 @@
 #include "objectrec.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
 
 const std::string DB_PATH    = "C:/Users/meetj/Downloads/ObjectRecognition/data/training/objectdb.csv";
 const std::string IMG_DIR    = "C:/Users/meetj/Downloads/ObjectRecognition/data/test_images/";
 const std::string RES_DIR    = "C:/Users/meetj/Downloads/ObjectRecognition/results/";
 const std::string MODEL_PATH = "C:/Users/meetj/Downloads/ObjectRecognition/data/resnet18-v2-7.onnx";
+const std::string STORE_PATH = "C:/Users/meetj/Downloads/ObjectRecognition/data/training/featurestore.csv";
 
 const std::vector<std::pair<std::string,std::string>> TRAIN_SET = {
     {"obj1_1.jpeg","object1"},{"obj1_2.jpeg","object1"},
@@ -50,12 +55,54 @@ int labelIndex(const std::string& l) {
     return -1;
 }
 
+bool hasFlag(int argc, char* argv[], const std::string& flag) {
+    for (int i = 1; i < argc; i++)
+        if (std::string(argv[i]) == flag) return true;
+    return false;
+}
+
+std::string flagValue(int argc, char* argv[], const std::string& flag, const std::string& def) {
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::string(argv[i]) == flag) return argv[i+1];
+    return def;
+}
+
+// --writers N --jpeg-quality Q --png-compression C
+WriterOptions writerOptions(int argc, char* argv[]) {
+    WriterOptions o;
+    o.threads        = std::stoi(flagValue(argc, argv, "--writers", std::to_string(o.threads)));
+    o.jpegQuality    = std::stoi(flagValue(argc, argv, "--jpeg-quality", std::to_string(o.jpegQuality)));
+    o.pngCompression = std::stoi(flagValue(argc, argv, "--png-compression", std::to_string(o.pngCompression)));
+    return o;
+}
+
+// --dnn-backend B --dnn-target T --dnn-threads N
+DnnOptions dnnOptions(int argc, char* argv[]) {
+    DnnOptions o;
+    o.backend = flagValue(argc, argv, "--dnn-backend", o.backend);
+    o.target  = flagValue(argc, argv, "--dnn-target", o.target);
+    o.threads = std::stoi(flagValue(argc, argv, "--dnn-threads", std::to_string(o.threads)));
+    return o;
+}
+
 int main(int argc, char* argv[]) {
     bool trainingMode = (argc > 1 && std::string(argv[1]) == "--train");
     bool demoMode     = (argc > 1 && std::string(argv[1]) == "--demo");
     bool cnnMode      = (argc > 1 && std::string(argv[1]) == "--cnn");
     bool unknownMode  = (argc > 1 && std::string(argv[1]) == "--unknown");
     bool guiMode      = (argc > 1 && std::string(argv[1]) == "--gui");
+    bool videoMode    = (argc > 1 && std::string(argv[1]) == "--video");
+    bool crossvalMode = (argc > 1 && std::string(argv[1]) == "--crossval");
+    bool exportMode   = (argc > 1 && std::string(argv[1]) == "--export-embeddings");
+    bool coarseMode   = (argc > 1 && std::string(argv[1]) == "--coarse");
+    bool reportMode   = (argc > 1 && std::string(argv[1]) == "--model-report");
+    // --adaptive can be combined with any mode for unevenly lit scenes
+    // --render writes annotated result images in evaluation and --cnn mode
+    // --model PATH swaps in another ONNX model (e.g. from prepare_model.py) for --cnn and --export-embeddings
+    bool render = hasFlag(argc, argv, "--render");
+    ThresholdMode threshMode = hasFlag(argc, argv, "--adaptive")
+        ? ThresholdMode::Adaptive : ThresholdMode::Isodata;
+    std::string modelPath = flagValue(argc, argv, "--model", MODEL_PATH);
     std::vector<TrainingEntry> db = loadTrainingData(DB_PATH);
 
     if (trainingMode) {
@@ -64,13 +111,11 @@ int main(int argc, char* argv[]) {
         for (auto& [fname, label] : TRAIN_SET) {
             cv::Mat src = cv::imread(IMG_DIR + fname);
             if (src.empty()) { std::cout << "Could not load: " << fname << std::endl; continue; }
-            cv::Mat binary  = applyThreshold(src);
+            cv::Mat binary  = applyThreshold(src, threshMode);
             cv::Mat cleaned = applyMorphology(binary);
-            cv::Mat labelViz;
-            std::vector<RegionInfo> regions = segmentRegions(cleaned, labelViz);
+            std::vector<RegionInfo> regions = segmentRegions(cleaned);
             if (!regions.empty()) {
-                cv::Mat featDisplay;
-                FeatureVector fv = computeFeatures(cleaned, regions[0], featDisplay);
+                FeatureVector fv = computeFeatures(cleaned, regions[0]);
                 TrainingEntry e; e.label = label; e.features = fv;
                 db.push_back(e);
                 std::cout << "Stored: " << label << " fill=" << fv.percentFilled << std::endl;
@@ -85,16 +130,15 @@ int main(int argc, char* argv[]) {
 
     if (unknownMode) {
         std::cout << "=== UNKNOWN OBJECT DETECTION ===" << std::endl;
+        ImageWriter writer(writerOptions(argc, argv));
         for (auto& fname : UNKNOWN_SET) {
             cv::Mat src = cv::imread(IMG_DIR + fname);
             if (src.empty()) { std::cout << "Could not load: " << fname << std::endl; continue; }
-            cv::Mat binary  = applyThreshold(src);
+            cv::Mat binary  = applyThreshold(src, threshMode);
             cv::Mat cleaned = applyMorphology(binary);
-            cv::Mat labelViz;
-            std::vector<RegionInfo> regions = segmentRegions(cleaned, labelViz);
+            std::vector<RegionInfo> regions = segmentRegions(cleaned);
             if (!regions.empty()) {
-                cv::Mat featDisplay;
-                FeatureVector fv = computeFeatures(cleaned, regions[0], featDisplay);
+                FeatureVector fv = computeFeatures(cleaned, regions[0]);
                 std::string predicted = classify(fv, db, 0.5);
                 cv::Mat result = src.clone();
                 cv::rectangle(result, regions[0].boundingBox, cv::Scalar(0,165,255), 2);
@@ -102,12 +146,14 @@ int main(int argc, char* argv[]) {
                     cv::FONT_HERSHEY_SIMPLEX, 1.2,
                     predicted == "unknown" ? cv::Scalar(0,0,255) : cv::Scalar(0,255,0), 2);
                 cv::imshow("Unknown Test - " + fname, result);
-                cv::imwrite(RES_DIR + "unknown_" + fname, result);
+                writer.write(RES_DIR + "unknown_" + fname, result);
                 std::cout << fname << " -> " << predicted << std::endl;
             }
             cv::waitKey(0);
             cv::destroyAllWindows();
         }
+        writer.flush();
+        writer.printStats();
         return 0;
     }
 
@@ -117,22 +163,34 @@ int main(int argc, char* argv[]) {
 
         int imgIdx = 0;
         bool unknownDetect = false;
+        int numImages = EVAL_SET.size();
 
-        while (true) {
-            auto& [fname, trueLabel] = EVAL_SET[imgIdx % EVAL_SET.size()];
-            cv::Mat src = cv::imread(IMG_DIR + fname);
-            if (src.empty()) { imgIdx++; continue; }
+        // Images are decoded, processed and their debug views rendered off the UI
+        // thread; a keypress only classifies cached features and redraws
+        ResultCache cache([threshMode](int idx) {
+            auto frame = std::make_shared<GuiFrame>();
+            frame->src = cv::imread(IMG_DIR + EVAL_SET[idx].first);
+            if (frame->src.empty()) return frame;
+            PipelineResult& res = frame->result;
+            res = runPipeline(frame->src, threshMode, true);
+            if (!res.regions.empty()) {
+                frame->regionsView  = renderRegions(res.labelMap, res.regions);
+                frame->featuresView = renderFeatures(res.cleaned, res.regions[0], res.features);
+            }
+            return frame;
+        }, 8);
 
-            cv::Mat binary  = applyThreshold(src);
-            cv::Mat cleaned = applyMorphology(binary);
-            cv::Mat labelViz;
-            std::vector<RegionInfo> regions = segmentRegions(cleaned, labelViz);
+        while (true) {
+            auto& [fname, trueLabel] = EVAL_SET[imgIdx];
+            std::shared_ptr<GuiFrame> frame = cache.get(imgIdx);
+            cache.prefetch((imgIdx + 1) % numImages);
+            cache.prefetch((imgIdx - 1 + numImages) % numImages);
+            if (frame->src.empty()) { imgIdx = (imgIdx + 1) % numImages; continue; }
 
-            cv::Mat display = src.clone();
+            const std::vector<RegionInfo>& regions = frame->result.regions;
+            cv::Mat display = frame->src.clone();
             if (!regions.empty()) {
-                cv::Mat featDisplay;
-                FeatureVector fv = computeFeatures(cleaned, regions[0], featDisplay);
-                std::string predicted = classify(fv, db, unknownDetect ? 0.5 : 1e9);
+                std::string predicted = classify(frame->result.features, db, unknownDetect ? 0.5 : 1e9);
 
                 cv::rectangle(display, regions[0].boundingBox, cv::Scalar(0,255,0), 2);
                 cv::putText(display, "Pred: " + predicted, cv::Point(20,40),
@@ -149,9 +207,9 @@ int main(int argc, char* argv[]) {
                     cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(200,200,200), 1);
 
                 cv::imshow("ObjectRec GUI", display);
-                cv::imshow("Threshold", binary);
-                cv::imshow("Regions", labelViz);
-                cv::imshow("Features", featDisplay);
+                cv::imshow("Threshold", frame->result.binary);
+                cv::imshow("Regions", frame->regionsView);
+                cv::imshow("Features", frame->featuresView);
             } else {
                 cv::putText(display, "No region found", cv::Point(20,40),
                     cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0,0,255), 2);
@@ -160,8 +218,8 @@ int main(int argc, char* argv[]) {
 
             int key = cv::waitKey(0) & 0xFF;
             if (key == 'q' || key == 'Q') break;
-            if (key == 'n' || key == 'N') imgIdx = (imgIdx + 1) % EVAL_SET.size();
-            if (key == 'p' || key == 'P') imgIdx = (imgIdx - 1 + EVAL_SET.size()) % EVAL_SET.size();
+            if (key == 'n' || key == 'N') imgIdx = (imgIdx + 1) % numImages;
+            if (key == 'p' || key == 'P') imgIdx = (imgIdx - 1 + numImages) % numImages;
             if (key == 'u' || key == 'U') {
                 unknownDetect = !unknownDetect;
                 std::cout << "Unknown detection: " << (unknownDetect ? "ON" : "OFF") << std::endl;
@@ -171,23 +229,339 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    if (coarseMode) {
+        int factor = (argc > 2 && argv[2][0] != '-') ? std::stoi(argv[2]) : 2;
+        if (factor < 1) { std::cout << "Coarse factor must be 1 or more" << std::endl; return 1; }
+        std::cout << "=== COARSE-TO-FINE (1/" << factor << ") vs FULL RESOLUTION ===" << std::endl;
+        cv::TickMeter fullTime, coarseTime;
+        const char* featNames[5] = {"percentFilled", "hwRatio", "hu1", "hu2", "hu3"};
+        double deviation[5] = {0, 0, 0, 0, 0}, centroidErr = 0;
+        int compared = 0, agree = 0;
+        for (auto& [fname, trueLabel] : EVAL_SET) {
+            std::string path = IMG_DIR + fname;
+            fullTime.start();
+            cv::Mat src = cv::imread(path);
+            PipelineResult ref;
+            if (!src.empty()) ref = runPipeline(src, threshMode);
+            fullTime.stop();
+
+            coarseTime.start();
+            cv::Mat fullImage;
+            PipelineResult fast = runCoarseToFine(path, factor, threshMode, fullImage);
+            coarseTime.stop();
+
+            if (ref.regions.empty() || fast.regions.empty()) {
+                std::cout << fname << ": no region in " << (ref.regions.empty() ? "full" : "coarse")
+                          << " path" << std::endl;
+                continue;
+            }
+            const FeatureVector& a = ref.features;
+            const FeatureVector& b = fast.features;
+            double diffs[5] = { a.percentFilled - b.percentFilled, a.hwRatio - b.hwRatio,
+                                a.hu1 - b.hu1, a.hu2 - b.hu2, a.hu3 - b.hu3 };
+            for (int f = 0; f < 5; f++) deviation[f] += std::abs(diffs[f]);
+            double err = cv::norm(ref.regions[0].centroid - fast.regions[0].centroid);
+            centroidErr += err;
+            std::string predFull = classify(a, db), predCoarse = classify(b, db);
+            if (predFull == predCoarse) agree++;
+            compared++;
+            std::cout << fname << ": full=" << predFull << " coarse=" << predCoarse
+                      << " centroid err=" << std::fixed << std::setprecision(2) << err << "px" << std::endl;
+        }
+        int images = EVAL_SET.size();
+        double fullMs = fullTime.getTimeMilli() / images, coarseMs = coarseTime.getTimeMilli() / images;
+        std::cout << "\nFull resolution:  " << fullMs << " ms/image" << std::endl;
+        std::cout << "Coarse-to-fine:   " << coarseMs << " ms/image" << std::endl;
+        std::cout << "Speedup:          " << fullMs / std::max(coarseMs, 1e-9) << "x" << std::endl;
+        if (compared > 0) {
+            std::cout << "\nMean absolute feature deviation over " << compared << " images:" << std::endl;
+            for (int f = 0; f < 5; f++)
+                std::cout << "  " << std::setw(14) << std::left << featNames[f] << std::right
+                          << std::setprecision(4) << deviation[f] / compared << std::endl;
+            std::cout << "Mean centroid error: " << std::setprecision(2) << centroidErr / compared << " px" << std::endl;
+            std::cout << "Label agreement:     " << agree << "/" << compared << std::endl;
+        }
+        return 0;
+    }
+
+    if (exportMode) {
+        std::cout << "=== EMBEDDING EXPORT ===" << std::endl;
+        cv::dnn::Net net = loadEmbeddingNet(modelPath, dnnOptions(argc, argv));
+        if (net.empty()) { std::cout << "Failed to load model!" << std::endl; return 1; }
+
+        // --save-crops also writes the network inputs of TRAIN_SET as int8 calibration
+        // data; held-out images stay out so --model-report accuracy is not calibrated on
+        if (hasFlag(argc, argv, "--save-crops")) {
+            cv::utils::fs::createDirectories(RES_DIR + "crops");
+            ImageWriter cropWriter(writerOptions(argc, argv));
+            for (auto& [fname, label] : TRAIN_SET) {
+                cv::Mat src = cv::imread(IMG_DIR + fname), crop;
+                if (src.empty() || !prepEmbeddingCrop(src, threshMode, crop)) continue;
+                cropWriter.write(RES_DIR + "crops/" + label + "_" + fname, std::move(crop));
+            }
+        }
+
+        // Same thresholding and rotation normalization the CNN classifier uses
+        std::unique_ptr<NpyWriter> npy;
+        std::ofstream labelsOut(RES_DIR + "embedding_labels.txt");
+        StreamingPCA pca;
+        int dims = 0;
+        for (auto& [fname, label] : EVAL_SET) {
+            cv::Mat src = cv::imread(IMG_DIR + fname);
+            if (src.empty()) { std::cout << "Could not load: " << fname << std::endl; continue; }
+            cv::Mat embimg;
+            if (!prepEmbeddingCrop(src, threshMode, embimg)) { std::cout << "No region found: " << fname << std::endl; continue; }
+            cv::Mat emb;
+            getEmbedding(embimg, net).reshape(1, 1).convertTo(emb, CV_32F);
+            if (!npy) {
+                dims = emb.cols;
+                npy = std::make_unique<NpyWriter>(RES_DIR + "embeddings.npy", dims);
+            }
+            npy->append(emb.ptr<float>());
+            pca.add(emb.ptr<float>(), dims);
+            labelsOut << label << "," << fname << "\n";
+            std::cout << "Embedded: " << label << " - " << fname << std::endl;
+        }
+        if (!npy) { std::cout << "No embeddings computed" << std::endl; return 1; }
+        npy->close();
+
+        // Project by streaming the vectors back from disk rather than holding them
+        pca.compute(2);
+        NpyReader reader(RES_DIR + "embeddings.npy");
+        NpyWriter projected(RES_DIR + "embeddings_pca.npy", 2);
+        std::vector<float> row;
+        while (reader.next(row)) projected.append(pca.project(row.data()).data());
+        projected.close();
+        std::cout << "Wrote " << pca.count() << " x " << dims << " embeddings, 2-D PCA and labels to "
+                  << RES_DIR << std::endl;
+        return 0;
+    }
+
+    if (crossvalMode) {
+        int folds = (argc > 2 && argv[2][0] != '-') ? std::stoi(argv[2]) : 0;
+        std::cout << "=== CROSS-VALIDATION ("
+                  << (folds > 1 ? std::to_string(folds) + "-fold" : "leave-one-out") << ") ===" << std::endl;
+
+        // Features come from the store; only new or changed images go through the pipeline
+        FeatureStore store(STORE_PATH);
+        cv::TickMeter featTime, evalTime;
+        featTime.start();
+        int nk = EVAL_SET.size(), nu = UNKNOWN_SET.size();
+        std::vector<StoredFeatures> stored(nk + nu);
+        cv::parallel_for_(cv::Range(0, nk + nu), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++)
+                stored[i] = store.get(IMG_DIR + (i < nk ? EVAL_SET[i].first : UNKNOWN_SET[i - nk]), threshMode);
+        });
+        featTime.stop();
+        store.save();
+
+        std::vector<TrainingEntry> known;
+        std::vector<FeatureVector> unknown;
+        for (int i = 0; i < nk + nu; i++) {
+            if (!stored[i].found) {
+                std::cout << "No region found: " << (i < nk ? EVAL_SET[i].first : UNKNOWN_SET[i - nk]) << std::endl;
+                continue;
+            }
+            if (i < nk) known.push_back({EVAL_SET[i].second, stored[i].features});
+            else unknown.push_back(stored[i].features);
+        }
+
+        evalTime.start();
+        CrossValResult result = crossValidate(known, unknown, folds);
+        std::vector<double> thresholds;
+        for (int t = 1; t <= 20; t++) thresholds.push_back(0.25 * t);
+        thresholds.push_back(1e9);   // no unknown rejection
+        std::vector<SweepRow> rows = sweepThresholds(known, result, thresholds);
+        evalTime.stop();
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "\nAccuracy without rejection: " << rows.back().tpr * 100.0 << "%" << std::endl;
+        std::cout << "\n" << std::setw(10) << "Threshold" << std::setw(10) << "Accuracy"
+                  << std::setw(8) << "TPR" << std::setw(8) << "FPR" << std::endl;
+        for (auto& r : rows)
+            std::cout << std::setw(10) << (r.threshold >= 1e9 ? std::string("none") : std::to_string(r.threshold).substr(0,4))
+                      << std::setw(10) << r.accuracy << std::setw(8) << r.tpr << std::setw(8) << r.fpr << std::endl;
+        std::cout << "\nTPR = known objects accepted with the right label, FPR = unknown objects accepted" << std::endl;
+        std::cout << "Features: " << featTime.getTimeMilli() << " ms (" << store.hits() << " cached, "
+                  << store.misses() << " computed), evaluation: " << evalTime.getTimeMilli() << " ms" << std::endl;
+        return 0;
+    }
+
+    if (videoMode) {
+        std::cout << "=== MOTION-GATED VIDEO MODE ===" << std::endl;
+        std::string source = (argc > 2 && argv[2][0] != '-') ? argv[2] : "0";
+        cv::VideoCapture cap;
+        if (std::all_of(source.begin(), source.end(), ::isdigit)) cap.open(std::stoi(source));
+        else cap.open(source);
+        if (!cap.isOpened()) { std::cout << "Could not open video: " << source << std::endl; return 1; }
+        bool headless = hasFlag(argc, argv, "--headless");
+
+        MotionGate gate;
+        cv::Mat frame, binary, cleaned;
+        double isoThresh = 0;   // ISODATA threshold of the last full refresh
+        std::vector<RegionInfo> regions;
+        std::vector<cv::Rect> dirty;
+        std::string predicted = "none";
+        cv::TickMeter processTime, totalTime;
+        int partialUpdates = 0;
+
+        while (cap.read(frame)) {
+            totalTime.start();
+            // Unchanged frames keep the previous regions and prediction
+            if (gate.update(frame, dirty)) {
+                processTime.start();
+                cv::Mat blurred = blurredGray(frame);
+                cv::Rect dirtyArea;
+                for (auto& d : dirty) dirtyArea |= d;
+                // Partial updates must binarize with the same threshold as the rest of
+                // the mask: a global shift in ISODATA, or the adaptive window (which
+                // reaches far outside the dirty rects), forces a full refresh
+                double thresh = threshMode == ThresholdMode::Isodata ? computeIsodataThreshold(blurred) : 0;
+                bool full = cleaned.empty() || threshMode == ThresholdMode::Adaptive ||
+                            std::abs(thresh - isoThresh) > 1.0 ||
+                            dirtyArea.area() > frame.cols * frame.rows / 2;
+                if (full) {
+                    gate.resetReference();
+                    isoThresh = thresh;
+                    binary = threshMode == ThresholdMode::Adaptive
+                        ? applyAdaptiveThreshold(blurred) : applyFixedThreshold(blurred, isoThresh);
+                    cleaned = applyMorphology(binary);
+                    regions = segmentRegions(cleaned);
+                } else {
+                    // Morphology reads up to 6 px around each dirty rect, so binarize that margin too
+                    cv::Rect whole(0, 0, frame.cols, frame.rows);
+                    for (auto& d : dirty) {
+                        cv::Rect outer = cv::Rect(d.x - 6, d.y - 6, d.width + 12, d.height + 12) & whole;
+                        applyFixedThreshold(blurred(outer), isoThresh).copyTo(binary(outer));
+                    }
+                    cleaned = applyMorphology(binary, dirty, cleaned);
+                    regions = segmentRegions(cleaned, dirtyArea, regions);
+                    partialUpdates++;
+                }
+                predicted = "none";
+                if (!regions.empty()) {
+                    FeatureVector fv = computeFeatures(cleaned, regions[0]);
+                    predicted = classify(fv, db);
+                }
+                processTime.stop();
+            }
+            totalTime.stop();
+
+            if (!headless) {
+                if (!regions.empty())
+                    cv::rectangle(frame, regions[0].boundingBox, cv::Scalar(0,255,0), 2);
+                cv::putText(frame, "Pred: " + predicted, cv::Point(20,40),
+                    cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(0,255,0), 2);
+                cv::putText(frame, "Skipped: " + std::to_string(gate.framesSkipped()) + "/" +
+                    std::to_string(gate.framesSeen()), cv::Point(20,80),
+                    cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(255,128,0), 2);
+                cv::imshow("ObjectRec Video", frame);
+                int key = cv::waitKey(1) & 0xFF;
+                if (key == 'q' || key == 'Q') break;
+            }
+        }
+
+        int seen = gate.framesSeen(), skippedFrames = gate.framesSkipped();
+        int processed = seen - skippedFrames;
+        double avgProcessMs = processed > 0 ? processTime.getTimeMilli() / processed : 0;
+        std::cout << "\n=== MOTION GATE STATS ===" << std::endl;
+        std::cout << "Frames:          " << seen << std::endl;
+        std::cout << "Processed:       " << processed << " (" << partialUpdates << " dirty-rect only)" << std::endl;
+        std::cout << "Skipped:         " << skippedFrames << std::fixed << std::setprecision(1)
+                  << " (" << (seen > 0 ? 100.0 * skippedFrames / seen : 0) << "%)" << std::endl;
+        std::cout << "Avg per frame:   " << std::setprecision(2)
+                  << (seen > 0 ? totalTime.getTimeMilli() / seen : 0) << " ms" << std::endl;
+        std::cout << "Avg processed:   " << avgProcessMs << " ms" << std::endl;
+        std::cout << "Est. CPU saved:  " << skippedFrames * avgProcessMs << " ms" << std::endl;
+        cv::destroyAllWindows();
+        return 0;
+    }
+
+    if (reportMode) {
+        // --model-report a.onnx b.onnx ... : latency and accuracy of each model on the same crops
+        std::vector<std::string> models;
+        for (int i = 2; i < argc && argv[i][0] != '-'; i++) models.push_back(argv[i]);
+        if (models.empty()) models.push_back(modelPath);
+        std::cout << "=== MODEL REPORT ===" << std::endl;
+
+        // Crops are prepared once so only the network differs between rows
+        std::vector<std::pair<std::string, cv::Mat>> trainCrops, evalCrops;
+        for (auto& [fname, label] : TRAIN_SET) {
+            cv::Mat src = cv::imread(IMG_DIR + fname), crop;
+            if (!src.empty() && prepEmbeddingCrop(src, threshMode, crop)) trainCrops.push_back({label, crop});
+        }
+        for (auto& [fname, label] : EVAL_SET) {
+            cv::Mat src = cv::imread(IMG_DIR + fname), crop;
+            if (!src.empty() && prepEmbeddingCrop(src, threshMode, crop)) evalCrops.push_back({label, crop});
+        }
+        if (evalCrops.empty()) { std::cout << "No crops prepared" << std::endl; return 1; }
+
+        DnnOptions opts = dnnOptions(argc, argv);
+        std::vector<cv::Mat> baseline;   // eval embeddings of the first model
+        std::cout << std::left << std::setw(40) << "model" << std::right
+                  << std::setw(10) << "load ms" << std::setw(10) << "ms/emb"
+                  << std::setw(8) << "dims" << std::setw(10) << "acc %" << std::setw(10) << "cos" << std::endl;
+        for (int m = 0; m < (int)models.size(); m++) {
+            cv::TickMeter loadTime, embTime;
+            loadTime.start();
+            cv::dnn::Net net = loadEmbeddingNet(models[m], opts);
+            loadTime.stop();
+            if (net.empty()) { std::cout << "Failed to load " << models[m] << std::endl; continue; }
+
+            std::vector<cv::Mat> trainEmb, evalEmb;
+            for (auto& [label, crop] : trainCrops) trainEmb.push_back(getEmbedding(crop, net).reshape(1, 1));
+            embTime.start();
+            for (auto& [label, crop] : evalCrops) evalEmb.push_back(getEmbedding(crop, net).reshape(1, 1));
+            embTime.stop();
+
+            int correct = 0;
+            for (int i = 0; i < (int)evalEmb.size(); i++) {
+                double bestDist = 1e18;
+                std::string predicted = "unknown";
+                for (int j = 0; j < (int)trainEmb.size(); j++) {
+                    double d = embeddingDistance(evalEmb[i], trainEmb[j]);
+                    if (d < bestDist) { bestDist = d; predicted = trainCrops[j].first; }
+                }
+                if (predicted == evalCrops[i].first) correct++;
+            }
+
+            // Mean cosine similarity to the first model, when the embeddings are comparable
+            std::string cosText = "-";
+            if (m == 0) baseline = evalEmb;
+            else if (!baseline.empty() && baseline[0].cols == evalEmb[0].cols) {
+                double sum = 0;
+                for (int i = 0; i < (int)evalEmb.size(); i++)
+                    sum += evalEmb[i].dot(baseline[i]) /
+                           std::max(cv::norm(evalEmb[i]) * cv::norm(baseline[i]), 1e-12);
+                std::ostringstream ss;
+                ss << std::fixed << std::setprecision(4) << sum / evalEmb.size();
+                cosText = ss.str();
+            }
+            std::cout << std::left << std::setw(40) << models[m] << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(10) << loadTime.getTimeMilli()
+                      << std::setprecision(2) << std::setw(10) << embTime.getTimeMilli() / evalEmb.size()
+                      << std::setw(8) << evalEmb[0].cols
+                      << std::setprecision(1) << std::setw(10) << 100.0 * correct / evalEmb.size()
+                      << std::setw(10) << cosText << std::endl;
+        }
+        return 0;
+    }
+
     if (cnnMode) {
         std::cout << "=== CNN EMBEDDING MODE ===" << std::endl;
-        cv::dnn::Net net = cv::dnn::readNetFromONNX(MODEL_PATH);
+        cv::dnn::Net net = loadEmbeddingNet(modelPath, dnnOptions(argc, argv));
         if (net.empty()) { std::cout << "Failed to load model!" << std::endl; return 1; }
-        std::cout << "ResNet18 loaded." << std::endl;
+        std::cout << "Model loaded: " << modelPath << std::endl;
 
         std::vector<std::pair<std::string, cv::Mat>> cnnDB;
         for (auto& [fname, label] : TRAIN_SET) {
             cv::Mat src = cv::imread(IMG_DIR + fname);
             if (src.empty()) continue;
-            cv::Mat binary  = applyThreshold(src);
+            cv::Mat binary  = applyThreshold(src, threshMode);
             cv::Mat cleaned = applyMorphology(binary);
-            cv::Mat labelViz;
-            std::vector<RegionInfo> regions = segmentRegions(cleaned, labelViz);
+            std::vector<RegionInfo> regions = segmentRegions(cleaned);
             if (!regions.empty()) {
-                cv::Mat featDisplay;
-                FeatureVector fv = computeFeatures(cleaned, regions[0], featDisplay);
+                FeatureVector fv = computeFeatures(cleaned, regions[0]);
                 cv::Mat embimg;
                 prepEmbeddingImage(src, embimg,
                     (int)regions[0].centroid.x, (int)regions[0].centroid.y,
@@ -201,19 +575,24 @@ int main(int argc, char* argv[]) {
         }
 
         std::cout << "\n=== CNN EVALUATION ===" << std::endl;
+        // Render and encode threads only exist when --render asks for output
+        std::unique_ptr<ImageWriter> writer;
+        std::unique_ptr<RenderWorker> renderer;
+        if (render) {
+            writer = std::make_unique<ImageWriter>(writerOptions(argc, argv));
+            renderer = std::make_unique<RenderWorker>();
+        }
         int n = LABELS.size();
         std::vector<std::vector<int>> confusion(n, std::vector<int>(n, 0));
         for (auto& [fname, trueLabel] : EVAL_SET) {
             cv::Mat src = cv::imread(IMG_DIR + fname);
             if (src.empty()) continue;
-            cv::Mat binary  = applyThreshold(src);
+            cv::Mat binary  = applyThreshold(src, threshMode);
             cv::Mat cleaned = applyMorphology(binary);
-            cv::Mat labelViz;
-            std::vector<RegionInfo> regions = segmentRegions(cleaned, labelViz);
+            std::vector<RegionInfo> regions = segmentRegions(cleaned);
             std::string predicted = "unknown";
             if (!regions.empty()) {
-                cv::Mat featDisplay;
-                FeatureVector fv = computeFeatures(cleaned, regions[0], featDisplay);
+                FeatureVector fv = computeFeatures(cleaned, regions[0]);
                 cv::Mat embimg;
                 prepEmbeddingImage(src, embimg,
                     (int)regions[0].centroid.x, (int)regions[0].centroid.y,
@@ -226,12 +605,13 @@ int main(int argc, char* argv[]) {
                     double d = embeddingDistance(emb, tEmb);
                     if (d < bestDist) { bestDist = d; predicted = lbl; }
                 }
-                cv::Mat result = src.clone();
-                cv::rectangle(result, regions[0].boundingBox, cv::Scalar(0,255,0), 2);
-                cv::putText(result, "CNN: " + predicted, cv::Point(20,50),
-                    cv::FONT_HERSHEY_SIMPLEX, 1.2,
-                    predicted==trueLabel ? cv::Scalar(0,255,0) : cv::Scalar(0,0,255), 2);
-                cv::imwrite(RES_DIR + "cnn_" + fname, result);
+                if (render) {
+                    renderer->submit([w = writer.get(), img = std::move(src), region = regions[0], predicted,
+                                      correct = predicted==trueLabel, name = fname]() mutable {
+                        renderPrediction(img, region, "CNN: " + predicted, correct, cv::Point(20,50));
+                        w->write(RES_DIR + "cnn_" + name, std::move(img));
+                    });
+                }
             }
             int ti = labelIndex(trueLabel), pi = labelIndex(predicted);
             if (ti >= 0 && pi >= 0) confusion[ti][pi]++;
@@ -255,27 +635,39 @@ int main(int argc, char* argv[]) {
         std::cout << "\nCNN Accuracy: " << correct << "/" << total
                   << " = " << std::fixed << std::setprecision(1)
                   << (100.0*correct/total) << "%" << std::endl;
+        if (render) {
+            renderer->wait();
+            writer->flush();
+            writer->printStats();
+        }
         return 0;
     }
     if (argc > 1 && std::string(argv[1]) == "--saveimages") {
         std::cout << "=== SAVING ALL PIPELINE IMAGES ===" << std::endl;
+        ImageWriter writer(writerOptions(argc, argv));
+        RenderWorker renderer;
         for (auto& [fname, trueLabel] : EVAL_SET) {
             cv::Mat src = cv::imread(IMG_DIR + fname);
             if (src.empty()) continue;
-            cv::Mat binary  = applyThreshold(src);
+            cv::Mat binary  = applyThreshold(src, threshMode);
             cv::Mat cleaned = applyMorphology(binary);
-            cv::Mat labelViz;
-            std::vector<RegionInfo> regions = segmentRegions(cleaned, labelViz);
-            cv::imwrite(RES_DIR + "thresh_" + fname, binary);
-            cv::imwrite(RES_DIR + "cleaned_" + fname, cleaned);
-            cv::imwrite(RES_DIR + "regions_" + fname, labelViz);
-            if (!regions.empty()) {
-                cv::Mat featDisplay;
-                FeatureVector fv = computeFeatures(cleaned, regions[0], featDisplay);
-                cv::imwrite(RES_DIR + "features_" + fname, featDisplay);
-            }
-            std::cout << "Saved: " << fname << std::endl;
+            cv::Mat labelMap;
+            std::vector<RegionInfo> regions = segmentRegions(cleaned, &labelMap);
+            FeatureVector fv{};
+            if (!regions.empty()) fv = computeFeatures(cleaned, regions[0]);
+            writer.write(RES_DIR + "thresh_" + fname, std::move(binary));
+            writer.write(RES_DIR + "cleaned_" + fname, cleaned);
+            renderer.submit([&writer, name = fname, cleaned, labelMap = std::move(labelMap),
+                             regions = std::move(regions), fv]() {
+                writer.write(RES_DIR + "regions_" + name, renderRegions(labelMap, regions));
+                if (!regions.empty())
+                    writer.write(RES_DIR + "features_" + name, renderFeatures(cleaned, regions[0], fv));
+            });
+            std::cout << "Processed: " << fname << std::endl;
         }
+        renderer.wait();
+        writer.flush();
+        writer.printStats();
         std::cout << "All images saved to results/" << std::endl;
         return 0;
     }
@@ -284,13 +676,12 @@ int main(int argc, char* argv[]) {
         for (auto& [fname, trueLabel] : EVAL_SET) {
             cv::Mat src = cv::imread(IMG_DIR + fname);
             if (src.empty()) continue;
-            cv::Mat binary  = applyThreshold(src);
+            cv::Mat binary  = applyThreshold(src, threshMode);
             cv::Mat cleaned = applyMorphology(binary);
-            cv::Mat labelViz;
-            std::vector<RegionInfo> regions = segmentRegions(cleaned, labelViz);
+            cv::Mat labelMap;
+            std::vector<RegionInfo> regions = segmentRegions(cleaned, &labelMap);
             if (!regions.empty()) {
-                cv::Mat featDisplay;
-                FeatureVector fv = computeFeatures(cleaned, regions[0], featDisplay);
+                FeatureVector fv = computeFeatures(cleaned, regions[0]);
                 std::string predicted = classify(fv, db);
                 cv::Mat result = src.clone();
                 cv::rectangle(result, regions[0].boundingBox, cv::Scalar(0,255,0), 3);
@@ -302,8 +693,8 @@ int main(int argc, char* argv[]) {
                 cv::imshow("1. Original", src);
                 cv::imshow("2. Thresholded", binary);
                 cv::imshow("3. Cleaned", cleaned);
-                cv::imshow("4. Regions", labelViz);
-                cv::imshow("5. Features", featDisplay);
+                cv::imshow("4. Regions", renderRegions(labelMap, regions));
+                cv::imshow("5. Features", renderFeatures(cleaned, regions[0], fv));
                 cv::imshow("6. Result", result);
             }
             cv::waitKey(0);
@@ -314,27 +705,34 @@ int main(int argc, char* argv[]) {
 
     // Normal evaluation
     std::cout << "=== EVALUATION MODE ===" << std::endl;
+    // Render and encode threads only exist when --render asks for output
+    std::unique_ptr<ImageWriter> writer;
+    std::unique_ptr<RenderWorker> renderer;
+    if (render) {
+        writer = std::make_unique<ImageWriter>(writerOptions(argc, argv));
+        renderer = std::make_unique<RenderWorker>();
+    }
     int n = LABELS.size();
     std::vector<std::vector<int>> confusion(n, std::vector<int>(n, 0));
     for (auto& [fname, trueLabel] : EVAL_SET) {
         cv::Mat src = cv::imread(IMG_DIR + fname);
         if (src.empty()) continue;
-        cv::Mat binary  = applyThreshold(src);
+        cv::Mat binary  = applyThreshold(src, threshMode);
         cv::Mat cleaned = applyMorphology(binary);
-        cv::Mat labelViz;
-        std::vector<RegionInfo> regions = segmentRegions(cleaned, labelViz);
+        std::vector<RegionInfo> regions = segmentRegions(cleaned);
         std::string predicted = "unknown";
         if (!regions.empty()) {
-            cv::Mat featDisplay;
-            FeatureVector fv = computeFeatures(cleaned, regions[0], featDisplay);
+            FeatureVector fv = computeFeatures(cleaned, regions[0]);
             predicted = classify(fv, db);
-            cv::Mat result = src.clone();
-            cv::rectangle(result, regions[0].boundingBox, cv::Scalar(0,255,0), 2);
-            cv::putText(result, predicted,
-                cv::Point(regions[0].boundingBox.x, regions[0].boundingBox.y-10),
-                cv::FONT_HERSHEY_SIMPLEX, 1.2,
-                predicted==trueLabel ? cv::Scalar(0,255,0) : cv::Scalar(0,0,255), 2);
-            cv::imwrite(RES_DIR + "classified_" + fname, result);
+            if (render) {
+                // src is not used again, so the worker takes it without a copy
+                renderer->submit([w = writer.get(), img = std::move(src), region = regions[0], predicted,
+                                  correct = predicted==trueLabel, name = fname]() mutable {
+                    renderPrediction(img, region, predicted, correct,
+                        cv::Point(region.boundingBox.x, region.boundingBox.y-10));
+                    w->write(RES_DIR + "classified_" + name, std::move(img));
+                });
+            }
         }
         int ti = labelIndex(trueLabel), pi = labelIndex(predicted);
         if (ti >= 0 && pi >= 0) confusion[ti][pi]++;
@@ -359,5 +757,10 @@ int main(int argc, char* argv[]) {
     std::cout << "\nAccuracy: " << correct << "/" << total
               << " = " << std::fixed << std::setprecision(1)
               << (100.0*correct/total) << "%" << std::endl;
+    if (render) {
+        renderer->wait();
+        writer->flush();
+        writer->printStats();
+    }
     return 0;
 }
\ No newline at end of file
@@ -36,10 +36,33 @@ static cv::Mat dilate(const cv::Mat& src, int ksize) {
     return dst;
 }
 
-cv::Mat applyMorphology(const cv::Mat& binary) {
+cv::Mat applyMorphology(const cv::Mat& binary, int openSize, int closeSize) {
     // Opening: removes small noise pixels
-    cv::Mat opened = dilate(erode(binary, 3), 3);
+    cv::Mat opened = dilate(erode(binary, openSize), openSize);
     // Closing: fills small holes inside objects
-    cv::Mat closed = erode(dilate(opened, 5), 5);
+    cv::Mat closed = erode(dilate(opened, closeSize), closeSize);
     return closed;
 }
+
+cv::Mat applyMorphology(const cv::Mat& binary) {
+    return applyMorphology(binary, 3, 5);
+}
+
+cv::Mat applyMorphology(const cv::Mat& binary, const std::vector<cv::Rect>& dirty, const cv::Mat& previous) {
+    if (previous.size() != binary.size()) return applyMorphology(binary);
+
+    // Each stage blanks ksize/2 pixels at the edge of its input, so a crop is
+    // exact everywhere at least 1+1+2+2 pixels away from its own border
+    const int reach = 6;
+    cv::Rect full(0, 0, binary.cols, binary.rows);
+    cv::Mat cleaned = previous.clone();
+    for (auto& d : dirty) {
+        cv::Rect inner = d & full;
+        if (inner.empty()) continue;
+        cv::Rect outer = cv::Rect(inner.x - reach, inner.y - reach,
+                                  inner.width + 2*reach, inner.height + 2*reach) & full;
+        cv::Mat part = applyMorphology(binary(outer));
+        part(inner - outer.tl()).copyTo(cleaned(inner));
+    }
+    return cleaned;
+}
@@ -0,0 +1,53 @@
+#include "objectrec.h"
+
+MotionGate::MotionGate(int downscale, int diffThresh, int minChangedPixels)
+    : downscale(std::max(1, downscale)), diffThresh(diffThresh), minChangedPixels(minChangedPixels) {}
+
+bool MotionGate::update(const cv::Mat& frame, std::vector<cv::Rect>& dirty) {
+    seen++;
+    dirty.clear();
+    cv::Rect full(0, 0, frame.cols, frame.rows);
+
+    cv::Mat gray, small;
+    if (frame.channels() == 3)
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    else
+        gray = frame;
+    // INTER_AREA averages each block, which also suppresses sensor noise
+    cv::resize(gray, small, cv::Size(), 1.0 / downscale, 1.0 / downscale, cv::INTER_AREA);
+    last = small;
+
+    if (reference.empty() || reference.size() != small.size()) {
+        reference = small.clone();
+        dirty.push_back(full);
+        return true;
+    }
+
+    // Compare against the frame the cached results describe, not the previous
+    // frame, so slow drift still triggers once it adds up
+    cv::Mat diff, changed;
+    cv::absdiff(small, reference, diff);
+    cv::threshold(diff, changed, diffThresh, 255, cv::THRESH_BINARY);
+    if (cv::countNonZero(changed) < minChangedPixels) {
+        skipped++;
+        return false;
+    }
+
+    // Join nearby changed cells, then scale each blob's box back to full resolution.
+    // Only those cells are refreshed in the reference: the caller reprocesses only
+    // the dirty rects, so drift elsewhere must keep adding up against the old frame.
+    cv::dilate(changed, changed, cv::Mat(), cv::Point(-1,-1), 1);
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(changed, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    cv::Rect smallFull(0, 0, small.cols, small.rows);
+    for (auto& c : contours) {
+        cv::Rect r = cv::boundingRect(c);
+        cv::Rect grown(r.x - 1, r.y - 1, r.width + 2, r.height + 2);
+        cv::Rect cell = grown & smallFull;
+        small(cell).copyTo(reference(cell));
+        cv::Rect big(grown.x * downscale, grown.y * downscale,
+                     grown.width * downscale, grown.height * downscale);
+        dirty.push_back(big & full);
+    }
+    return true;
+}
@@ -0,0 +1,15 @@
+#include "objectrec.h"
+
+PipelineResult runPipeline(const cv::Mat& src, ThresholdMode mode, bool keepImages) {
+    PipelineResult res;
+    cv::Mat binary  = applyThreshold(src, mode);
+    cv::Mat cleaned = applyMorphology(binary);
+    res.regions = segmentRegions(cleaned, keepImages ? &res.labelMap : nullptr);
+    if (!res.regions.empty())
+        res.features = computeFeatures(cleaned, res.regions[0]);
+    if (keepImages) {
+        res.binary  = binary;
+        res.cleaned = cleaned;
+    }
+    return res;
+}
@@ -0,0 +1,52 @@
+#include "objectrec.h"
+
+void renderPrediction(cv::Mat& img, const RegionInfo& region, const std::string& text,
+                      bool correct, cv::Point textAt) {
+    cv::rectangle(img, region.boundingBox, cv::Scalar(0,255,0), 2);
+    cv::putText(img, text, textAt, cv::FONT_HERSHEY_SIMPLEX, 1.2,
+        correct ? cv::Scalar(0,255,0) : cv::Scalar(0,0,255), 2);
+}
+
+RenderWorker::RenderWorker(size_t maxQueued)
+    : capacity(std::max<size_t>(1, maxQueued)), worker(&RenderWorker::run, this) {}
+
+RenderWorker::~RenderWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void RenderWorker::submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        notFull.wait(lock, [this]{ return tasks.size() < capacity; });
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void RenderWorker::wait() {
+    std::unique_lock<std::mutex> lock(mtx);
+    idle.wait(lock, [this]{ return tasks.empty() && !busy; });
+}
+
+void RenderWorker::run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        wake.wait(lock, [this]{ return stopping || !tasks.empty(); });
+        // Drain the queue before honouring stop so nothing submitted is lost
+        if (tasks.empty()) break;
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        busy = true;
+        lock.unlock();
+        notFull.notify_one();
+        task();
+        lock.lock();
+        busy = false;
+        if (tasks.empty()) idle.notify_all();
+    }
+}
@@ -0,0 +1,36 @@
+#include "objectrec.h"
+
+ResultCache::ResultCache(Loader load, size_t cap) : loader(std::move(load)), capacity(std::max<size_t>(1, cap)) {}
+
+std::shared_future<std::shared_ptr<GuiFrame>> ResultCache::lookup(int idx) {
+    auto it = entries.find(idx);
+    if (it != entries.end()) {
+        order.splice(order.begin(), order, it->second.second);
+        return it->second.first;
+    }
+
+    std::shared_future<std::shared_ptr<GuiFrame>> fut =
+        std::async(std::launch::async, loader, idx).share();
+    order.push_front(idx);
+    entries[idx] = {fut, order.begin()};
+
+    // Evict from the cold end, skipping anything still in flight
+    for (auto victim = std::prev(order.end()); entries.size() > capacity && victim != order.begin(); ) {
+        auto& entry = entries[*victim];
+        auto prev = std::prev(victim);
+        if (entry.first.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            entries.erase(*victim);
+            order.erase(victim);
+        }
+        victim = prev;
+    }
+    return fut;
+}
+
+std::shared_ptr<GuiFrame> ResultCache::get(int idx) {
+    return lookup(idx).get();
+}
+
+void ResultCache::prefetch(int idx) {
+    lookup(idx);
+}
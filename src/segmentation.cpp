@@ -1,19 +1,12 @@
 #include "objectrec.h"
 
-std::vector<RegionInfo> segmentRegions(const cv::Mat& binary, cv::Mat& labelViz) {
+static const int DEFAULT_MIN_AREA = 500;
+
+std::vector<RegionInfo> segmentRegions(const cv::Mat& binary, cv::Mat* labelMap, int minArea) {
     cv::Mat labels, stats, centroids;
     int numLabels = cv::connectedComponentsWithStats(binary, labels, stats, centroids);
 
-    int minArea = 500;
     int imgW = binary.cols, imgH = binary.rows;
-
-    // Random color palette
-    std::vector<cv::Vec3b> colors(numLabels);
-    colors[0] = cv::Vec3b(0,0,0); // background black
-    for (int i = 1; i < numLabels; i++)
-        colors[i] = cv::Vec3b(rand()%200+55, rand()%200+55, rand()%200+55);
-
-    labelViz = cv::Mat::zeros(binary.size(), CV_8UC3);
     std::vector<RegionInfo> regions;
 
     for (int i = 1; i < numLabels; i++) {
@@ -33,15 +26,87 @@ std::vector<RegionInfo> segmentRegions(const cv::Mat& binary, cv::Mat& labelViz)
         r.area     = area;
         r.boundingBox = cv::Rect(x, y, w, h);
         regions.push_back(r);
-
-        // Color the region
-        for (int row = 0; row < binary.rows; row++)
-            for (int col = 0; col < binary.cols; col++)
-                if (labels.at<int>(row,col) == i)
-                    labelViz.at<cv::Vec3b>(row,col) = colors[i];
     }
 
     // Sort by area descending, keep largest
+    std::sort(regions.begin(), regions.end(),
+        [](const RegionInfo& a, const RegionInfo& b){ return a.area > b.area; });
+
+    if (labelMap) *labelMap = labels;
+    return regions;
+}
+
+cv::Mat renderRegions(const cv::Mat& labelMap, const std::vector<RegionInfo>& regions) {
+    // Random color palette, black for background and filtered-out components.
+    // Local RNG rather than rand() so regions can be rendered on worker threads.
+    double maxLabel = 0;
+    cv::minMaxLoc(labelMap, nullptr, &maxLabel);
+    std::vector<cv::Vec3b> colors((int)maxLabel + 1, cv::Vec3b(0,0,0));
+    cv::RNG rng(regions.size());
+    for (auto& r : regions)
+        colors[r.label] = cv::Vec3b(rng.uniform(55,255), rng.uniform(55,255), rng.uniform(55,255));
+
+    cv::Mat labelViz(labelMap.size(), CV_8UC3);
+    for (int row = 0; row < labelMap.rows; row++) {
+        const int* lbl = labelMap.ptr<int>(row);
+        cv::Vec3b* out = labelViz.ptr<cv::Vec3b>(row);
+        for (int col = 0; col < labelMap.cols; col++)
+            out[col] = colors[lbl[col]];
+    }
+    return labelViz;
+}
+
+std::vector<RegionInfo> segmentRegions(const cv::Mat& binary, const cv::Rect& dirty,
+                                       const std::vector<RegionInfo>& previous) {
+    cv::Rect full(0, 0, binary.cols, binary.rows);
+
+    // Grow the dirty area over every previous region it touches so moved or
+    // grown objects are relabelled in one piece
+    cv::Rect roi = dirty & full;
+    if (roi.empty()) return previous;
+    for (bool grown = true; grown; ) {
+        grown = false;
+        for (auto& p : previous) {
+            if ((p.boundingBox & roi).area() > 0 && (p.boundingBox | roi) != roi) {
+                roi |= p.boundingBox;
+                grown = true;
+            }
+        }
+    }
+    roi = cv::Rect(roi.x - 2, roi.y - 2, roi.width + 4, roi.height + 4) & full;
+
+    cv::Mat labels, stats, centroids;
+    int numLabels = cv::connectedComponentsWithStats(binary(roi), labels, stats, centroids);
+
+    std::vector<RegionInfo> regions;
+    for (auto& p : previous)
+        if ((p.boundingBox & roi).area() == 0) regions.push_back(p);
+
+    for (int i = 1; i < numLabels; i++) {
+        int area  = stats.at<int>(i, cv::CC_STAT_AREA);
+        int x     = stats.at<int>(i, cv::CC_STAT_LEFT);
+        int y     = stats.at<int>(i, cv::CC_STAT_TOP);
+        int w     = stats.at<int>(i, cv::CC_STAT_WIDTH);
+        int h     = stats.at<int>(i, cv::CC_STAT_HEIGHT);
+
+        // A component cut by the ROI edge may continue outside it - relabel everything
+        bool cut = (x == 0 && roi.x > 0) || (y == 0 && roi.y > 0) ||
+                   (x+w == roi.width  && roi.x+roi.width  < full.width) ||
+                   (y+h == roi.height && roi.y+roi.height < full.height);
+        if (cut) return segmentRegions(binary);
+
+        x += roi.x; y += roi.y;
+        if (area < DEFAULT_MIN_AREA) continue;
+        if (x <= 1 || y <= 1 || x+w >= full.width-1 || y+h >= full.height-1) continue;
+
+        RegionInfo r;
+        r.label    = i;
+        r.centroid = cv::Point2f(centroids.at<double>(i,0) + roi.x, centroids.at<double>(i,1) + roi.y);
+        r.area     = area;
+        r.boundingBox = cv::Rect(x, y, w, h);
+        regions.push_back(r);
+    }
+
     std::sort(regions.begin(), regions.end(),
         [](const RegionInfo& a, const RegionInfo& b){ return a.area > b.area; });
 
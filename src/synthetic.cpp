@@ -0,0 +1,175 @@
+#include "synthetic.h"
+#include <cmath>
+#include <map>
+
+const std::vector<std::string>& syntheticShapes() {
+    static const std::vector<std::string> shapes = {
+        "rect", "ellipse", "triangle", "lshape", "cross", "ring"
+    };
+    return shapes;
+}
+
+// Outline (and optional hole) of a shape in unit coordinates, x in [-0.5,0.5]
+static void unitShape(const std::string& shape, double aspect,
+                      std::vector<cv::Point2d>& outer, std::vector<cv::Point2d>& hole) {
+    double h = 0.5 * aspect;
+    if (shape == "rect") {
+        outer = { {-0.5,-h}, {0.5,-h}, {0.5,h}, {-0.5,h} };
+    } else if (shape == "triangle") {
+        outer = { {-0.5,h}, {0.5,h}, {-0.1,-h} };
+    } else if (shape == "lshape") {
+        outer = { {-0.5,-h}, {-0.1,-h}, {-0.1,h*0.2}, {0.5,h*0.2}, {0.5,h}, {-0.5,h} };
+    } else if (shape == "cross") {
+        double t = 0.17;
+        outer = { {-t,-h}, {t,-h}, {t,-t*aspect}, {0.5,-t*aspect}, {0.5,t*aspect}, {t,t*aspect},
+                  {t,h}, {-t,h}, {-t,t*aspect}, {-0.5,t*aspect}, {-0.5,-t*aspect}, {-t,-t*aspect} };
+    } else {
+        // ellipse and ring
+        for (int i = 0; i < 48; i++) {
+            double a = 2 * M_PI * i / 48;
+            outer.push_back({0.5 * cos(a), h * sin(a)});
+            if (shape == "ring") hole.push_back({0.25 * cos(a), 0.5 * h * sin(a)});
+        }
+    }
+}
+
+static std::vector<cv::Point> placeShape(const std::vector<cv::Point2d>& unit,
+                                         cv::Point2f center, int size, float angle) {
+    double a = angle * M_PI / 180.0, ca = cos(a), sa = sin(a);
+    std::vector<cv::Point> pts;
+    for (auto& p : unit) {
+        double x = p.x * size, y = p.y * size;
+        pts.push_back(cv::Point((int)std::lround(center.x + x*ca - y*sa),
+                                (int)std::lround(center.y + x*sa + y*ca)));
+    }
+    return pts;
+}
+
+cv::Mat renderShapeMask(const std::string& shape, int size, float angle, double aspect) {
+    std::vector<cv::Point2d> outer, hole;
+    unitShape(shape, aspect, outer, hole);
+    int canvas = (int)(size * 1.5) + 8;
+    cv::Point2f center(canvas / 2.0f, canvas / 2.0f);
+    cv::Mat mask = cv::Mat::zeros(canvas, canvas, CV_8UC1);
+    cv::fillPoly(mask, std::vector<std::vector<cv::Point>>{placeShape(outer, center, size, angle)},
+                 cv::Scalar(255));
+    if (!hole.empty())
+        cv::fillPoly(mask, std::vector<std::vector<cv::Point>>{placeShape(hole, center, size, angle)},
+                     cv::Scalar(0));
+    return mask;
+}
+
+cv::Mat renderScene(const SceneParams& params, std::vector<SceneObject>& objects) {
+    cv::RNG rng(params.seed);
+    const std::vector<std::string>& shapes = params.shapes.empty() ? syntheticShapes() : params.shapes;
+    int W = params.width, H = params.height;
+    objects.clear();
+
+    // Object reflectance, 0 = background
+    cv::Mat albedo = cv::Mat::zeros(H, W, CV_8UC1);
+    const int margin = 4;
+    for (int i = 0; i < params.numObjects; i++) {
+        for (int attempt = 0; attempt < 50; attempt++) {
+            std::string shape = shapes[rng.uniform(0, (int)shapes.size())];
+            int size = rng.uniform(params.minSize, params.maxSize + 1);
+            double aspect = rng.uniform(0.4, 1.0);
+            float angle = params.rotate ? (float)rng.uniform(0.0, 360.0) : 0.0f;
+            cv::Point2f center((float)rng.uniform(0, W), (float)rng.uniform(0, H));
+
+            std::vector<cv::Point2d> outer, hole;
+            unitShape(shape, aspect, outer, hole);
+            std::vector<cv::Point> pts = placeShape(outer, center, size, angle);
+            cv::Rect bbox = cv::boundingRect(pts);
+            if (bbox.x < margin || bbox.y < margin ||
+                bbox.x + bbox.width >= W - margin || bbox.y + bbox.height >= H - margin) continue;
+
+            cv::Rect padded(bbox.x - margin, bbox.y - margin,
+                            bbox.width + 2*margin, bbox.height + 2*margin);
+            bool overlaps = false;
+            for (auto& o : objects)
+                if ((o.boundingBox & padded).area() > 0) { overlaps = true; break; }
+            if (overlaps) continue;
+
+            cv::fillPoly(albedo, std::vector<std::vector<cv::Point>>{pts},
+                         cv::Scalar(rng.uniform(20, 80)));
+            if (!hole.empty())
+                cv::fillPoly(albedo, std::vector<std::vector<cv::Point>>{placeShape(hole, center, size, angle)},
+                             cv::Scalar(0));
+            objects.push_back({shape, bbox, center, angle});
+            break;
+        }
+    }
+
+    // Linear lighting falloff in a random direction
+    double dir = rng.uniform(0.0, 2 * M_PI), dx = cos(dir), dy = sin(dir);
+    double bg = rng.uniform(190, 235);
+    cv::Mat gray(H, W, CV_32FC1);
+    for (int r = 0; r < H; r++) {
+        const uchar* a = albedo.ptr<uchar>(r);
+        float* g = gray.ptr<float>(r);
+        for (int c = 0; c < W; c++) {
+            // t in [0,1] along the light direction
+            double t = 0.5 + ((c + 0.5) / W - 0.5) * dx / M_SQRT2 + ((r + 0.5) / H - 0.5) * dy / M_SQRT2;
+            double light = 1.0 - params.gradient * t;
+            g[c] = (float)((a[c] ? a[c] : bg) * light);
+        }
+    }
+
+    if (params.noiseSigma > 0) {
+        cv::Mat noise(H, W, CV_32FC1);
+        rng.fill(noise, cv::RNG::NORMAL, 0.0, params.noiseSigma);
+        gray += noise;
+    }
+
+    cv::Mat gray8, bgr;
+    gray.convertTo(gray8, CV_8UC1);
+    cv::cvtColor(gray8, bgr, cv::COLOR_GRAY2BGR);
+    return bgr;
+}
+
+std::vector<TrainingEntry> makeSyntheticDB(int entries, const std::vector<std::string>& shapes,
+                                           uint64_t seed) {
+    if (shapes.empty() || entries <= 0) return {};
+    cv::RNG rng(seed);
+    const int protosPerShape = 8;
+
+    // Mean and stdev of each feature per shape from real pipeline runs
+    std::map<std::string, std::pair<cv::Mat, cv::Mat>> dist;
+    for (auto& shape : shapes) {
+        cv::Mat samples(0, 5, CV_64FC1);
+        for (int i = 0; i < protosPerShape; i++) {
+            cv::Mat mask = renderShapeMask(shape, rng.uniform(80, 200),
+                                           (float)rng.uniform(0.0, 360.0), rng.uniform(0.6, 0.9));
+            std::vector<RegionInfo> regions = segmentRegions(mask);
+            if (regions.empty()) continue;
+            FeatureVector fv = computeFeatures(mask, regions[0]);
+            cv::Mat row = (cv::Mat_<double>(1, 5) << fv.percentFilled, fv.hwRatio, fv.hu1, fv.hu2, fv.hu3);
+            samples.push_back(row);
+        }
+        cv::Mat m(1, 5, CV_64FC1), s(1, 5, CV_64FC1);
+        for (int f = 0; f < 5; f++) {
+            cv::Mat col = samples.col(f);
+            cv::Scalar mu, sd;
+            if (samples.rows > 0) cv::meanStdDev(col, mu, sd);
+            m.at<double>(f) = mu[0];
+            s.at<double>(f) = std::max(sd[0], 1e-3);
+        }
+        dist[shape] = {m, s};
+    }
+
+    std::vector<TrainingEntry> db;
+    db.reserve(entries);
+    for (int i = 0; i < entries; i++) {
+        const std::string& shape = shapes[i % shapes.size()];
+        const cv::Mat& m = dist[shape].first;
+        const cv::Mat& s = dist[shape].second;
+        double v[5];
+        for (int f = 0; f < 5; f++)
+            v[f] = m.at<double>(f) + rng.gaussian(s.at<double>(f));
+        TrainingEntry e;
+        e.label = shape;
+        e.features = {v[0], v[1], v[2], v[3], v[4]};
+        db.push_back(e);
+    }
+    return db;
+}
@@ -6,18 +6,7 @@
 
 // Custom ISODATA dynamic thresholding - written from scratch
 // Samples 1/16 of pixels, runs K=2 means iteration to find threshold
-cv::Mat applyThreshold(const cv::Mat& src) {
-    cv::Mat gray, blurred;
-
-    // Convert to grayscale
-    if (src.channels() == 3)
-        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
-    else
-        gray = src.clone();
-
-    // Slight blur to reduce noise
-    cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0);
-
+double computeIsodataThreshold(const cv::Mat& blurred) {
     // Sample 1/16 of pixels randomly
     std::vector<uchar> samples;
     int step = 4; // every 4th pixel in x and y = 1/16
@@ -45,8 +34,10 @@ cv::Mat applyThreshold(const cv::Mat& src) {
     }
 
     // Threshold = midpoint between the two cluster means
-    double thresh = (m1 + m2) / 2.0;
+    return (m1 + m2) / 2.0;
+}
 
+cv::Mat applyFixedThreshold(const cv::Mat& blurred, double thresh) {
     // Apply threshold manually (from scratch - pixels below thresh are object/dark)
     cv::Mat binary(blurred.rows, blurred.cols, CV_8UC1);
     for (int r = 0; r < blurred.rows; r++)
@@ -55,3 +46,84 @@ cv::Mat applyThreshold(const cv::Mat& src) {
 
     return binary;
 }
+
+// Bradley-style adaptive thresholding - written from scratch
+// A pixel is object/dark if it is more than `k` below the mean of the
+// window x window neighbourhood around it. Window sums come from an
+// integral image, so the cost per pixel is O(1) regardless of window size.
+cv::Mat applyAdaptiveThreshold(const cv::Mat& gray, int window, double k) {
+    int rows = gray.rows, cols = gray.cols;
+
+    // Integral image with one extra row/col of zeros (doubles are exact far past 4K frames).
+    // Built in two parallel passes: prefix sums along each row, then down each column.
+    cv::Mat integ(rows + 1, cols + 1, CV_64FC1, cv::Scalar(0));
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            const uchar* src = gray.ptr<uchar>(r);
+            double* cur = integ.ptr<double>(r + 1);
+            double rowSum = 0;
+            for (int c = 0; c < cols; c++) {
+                rowSum += src[c];
+                cur[c + 1] = rowSum;
+            }
+        }
+    });
+    // Column blocks keep each row access contiguous instead of striding one column at a time
+    const int block = 64;
+    cv::parallel_for_(cv::Range(0, (cols + block - 1) / block), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            int c0 = 1 + b * block, c1 = std::min(cols + 1, c0 + block);
+            for (int r = 2; r <= rows; r++) {
+                const double* above = integ.ptr<double>(r - 1);
+                double* cur = integ.ptr<double>(r);
+                for (int c = c0; c < c1; c++) cur[c] += above[c];
+            }
+        }
+    });
+
+    // Window must be larger than the objects or their interiors fall back to background
+    if (window <= 0) window = std::max(rows, cols) / 4;
+    int half = std::max(1, window / 2);
+    double scale = 1.0 - k;
+    cv::Mat binary(rows, cols, CV_8UC1);
+
+    // Rows are independent once the integral image exists
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            int r0 = std::max(0, r - half), r1 = std::min(rows, r + half + 1);
+            const double* top = integ.ptr<double>(r0);
+            const double* bot = integ.ptr<double>(r1);
+            const uchar* src = gray.ptr<uchar>(r);
+            uchar* dst = binary.ptr<uchar>(r);
+            for (int c = 0; c < cols; c++) {
+                int c0 = std::max(0, c - half), c1 = std::min(cols, c + half + 1);
+                double sum = bot[c1] - bot[c0] - top[c1] + top[c0];
+                double area = (double)(r1 - r0) * (c1 - c0);
+                dst[c] = (src[c] * area < sum * scale) ? 255 : 0;
+            }
+        }
+    });
+
+    return binary;
+}
+
+cv::Mat blurredGray(const cv::Mat& src) {
+    cv::Mat gray, blurred;
+
+    // Convert to grayscale
+    if (src.channels() == 3)
+        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+    else
+        gray = src.clone();
+
+    // Slight blur to reduce noise
+    cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0);
+    return blurred;
+}
+
+cv::Mat applyThreshold(const cv::Mat& src, ThresholdMode mode) {
+    cv::Mat blurred = blurredGray(src);
+    if (mode == ThresholdMode::Adaptive)
+        return applyAdaptiveThreshold(blurred);
+    return applyFixedThreshold(blurred, computeIsodataThreshold(blurred));
+}